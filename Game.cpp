@@ -8,14 +8,42 @@
 #include <vector> // For Dynamic arrays
 #include <fstream> // For reading from files
 #include <sstream> // For string stream processing
+#include <iomanip> // For aligned report tables
 #include <optional> // For handling events safely
 #include <algorithm> // Randomizing question/answer order
 #include <random> // Used for shuffle()
 #include <chrono> // For Clock and Time functions
 #include <memory> // For saving memory, deletes background image to save memory leaks
+#include <thread> // For running the camera on its own thread
+#include <atomic> // For sharing gesture results between threads without locks
+#include <filesystem> // For listing recorded image sequences
+#include <new> // For the debug allocation counter
+#include <cerrno> // For ENOMEM in the debug allocation counter
+#include <array> // For fixed-size lookup tables
+#include <cstring> // For memcpy
+#include <bit> // For countr_zero when scanning bit masks
+#include <map> // For per-difficulty leaderboards
+#include <mutex> // For handing score snapshots to the writer thread
+#include <condition_variable> // For waking the writer thread
+#include <utility> // For exchange()
+#include <string_view> // For reading questions straight out of a mapped bank
+#include <numeric> // For iota
+#include <charconv> // For from_chars in the question parser
+#include <unordered_map> // For sharing repeated strings when compiling a bank
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#define NOGDI
+#include <windows.h> // For mapping question banks
+#else
+#include <fcntl.h> // For mapping question banks
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgproc.hpp>
-#include <opencv2/highgui.hpp>
+#include <opencv2/core/hal/intrin.hpp> // OpenCV universal intrinsics (SSE/AVX/NEON behind one API)
 
 using namespace std;
 using namespace sf;
@@ -26,6 +54,10 @@ const int WINDOW_WIDTH = 1600;
 const int WINDOW_HEIGHT = 900;
 const float TIME_PER_QUESTION = 15.0f;
 
+// Difficulties, in the order the question banks are loaded
+const char* const DIFFICULTY_LABELS[] = { "Easy", "Medium", "Hard" }; // Button captions
+const char* const DIFFICULTY_NAMES[] = { "Easy Mode", "Medium Mode", "Hard Mode" }; // Titles and leaderboards
+
 // Colors
 const Color BACKGROUND_COLOR(30, 0, 60);
 const Color UI_BASE_COLOR(25, 10, 50, 150);
@@ -33,247 +65,3112 @@ const Color CORRECT_COLOR(40, 180, 99);
 const Color INCORRECT_COLOR(231, 76, 60);
 const Color DEFAULT_OUTLINE_COLOR(150, 100, 255);
 
-// Game States
-enum GameState {
-    MENU,
-    SELECT_DIFFICULTY,
-    SET_LIMIT,
-    SETTINGS,
-    QUIZ_MODE,
-    PAUSED,
-    GAME_OVER
-};
+// Debug Allocation Counter
+// Build with -DGESTURE_COUNT_ALLOCATIONS to count heap allocations, per thread and across the whole process
+// Used by --bench-gesture to prove the gesture pipeline stops allocating once it is warmed up
+#ifdef GESTURE_COUNT_ALLOCATIONS
+thread_local uint64_t threadAllocationCount = 0;
+atomic<uint64_t> processAllocationCount{ 0 };
+
+inline void countAllocation() {
+    threadAllocationCount++;
+    processAllocationCount.fetch_add(1, memory_order_relaxed);
+}
+
+#if defined(__GLIBC__)
+// glibc: replace malloc itself, so cv::fastMalloc, the AutoBuffers inside convexHull/convexityDefects
+// and allocations on OpenCV's worker threads are all counted, not only our own operator new calls
+const char* const ALLOCATION_COUNTER = "malloc";
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size) noexcept { countAllocation(); return __libc_malloc(size); }
+void* calloc(size_t count, size_t size) noexcept { countAllocation(); return __libc_calloc(count, size); }
+void* realloc(void* p, size_t size) noexcept { countAllocation(); return __libc_realloc(p, size); }
+void* memalign(size_t alignment, size_t size) noexcept { countAllocation(); return __libc_memalign(alignment, size); }
+void* aligned_alloc(size_t alignment, size_t size) noexcept { countAllocation(); return __libc_memalign(alignment, size); }
+int posix_memalign(void** out, size_t alignment, size_t size) noexcept {
+    countAllocation();
+    void* p = __libc_memalign(alignment, size);
+    if (!p && size) return ENOMEM;
+    *out = p;
+    return 0;
+}
+}
+
+inline void installAllocationCounter() {} // operator new and cv::fastMalloc already end up in malloc
+#else
+// Elsewhere only operator new and cv::Mat buffers are counted: scratch buffers OpenCV allocates
+// internally with cv::fastMalloc/AutoBuffer are missed, so treat the numbers as a lower bound
+const char* const ALLOCATION_COUNTER = "operator_new_and_mat";
+
+void* operator new(size_t size) {
+    countAllocation();
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const nothrow_t&) noexcept {
+    countAllocation();
+    return malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, const nothrow_t&) noexcept { free(p); }
+void operator delete[](void* p, const nothrow_t&) noexcept { free(p); }
+
+// cv::Mat buffers come from cv::fastMalloc, so they are counted through the Mat allocator instead
+class CountingMatAllocator : public MatAllocator {
+public:
+    UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, AccessFlag flags, UMatUsageFlags usageFlags) const override {
+        if (!data) countAllocation(); // Wrapping user memory is not an allocation
+        return base->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+    bool allocate(UMatData* data, AccessFlag accessFlags, UMatUsageFlags usageFlags) const override {
+        return base->allocate(data, accessFlags, usageFlags);
+    }
+    void deallocate(UMatData* data) const override { base->deallocate(data); }
+
+private:
+    MatAllocator* base = Mat::getStdAllocator();
+};
+
+inline void installAllocationCounter() {
+    static CountingMatAllocator allocator;
+    Mat::setDefaultAllocator(&allocator);
+}
+#endif
+
+inline uint64_t allocationCount() { return threadAllocationCount; } // This thread only
+inline uint64_t processAllocations() { return processAllocationCount.load(memory_order_relaxed); } // Every thread
+#else
+inline uint64_t allocationCount() { return 0; }
+inline uint64_t processAllocations() { return 0; }
+inline void installAllocationCounter() {}
+#endif
+
+// Game States
+enum GameState {
+    MENU,
+    SELECT_DIFFICULTY,
+    SET_LIMIT,
+    SETTINGS,
+    QUIZ_MODE,
+    PAUSED,
+    GAME_OVER
+};
+
+// Data Structure
+// One parsed line of a text bank, only produced by the original loader below (the --bench-parser baseline)
+struct QuizQuestion {
+    string questionText;
+    vector<string> options; // Dynamic list to store 4 options
+    int correctAnswerIndex;
+};
+
+vector<QuizQuestion> loadQuestionsFromFile(const string& filename);
+
+// Particles for wrong answers
+// Fixed-capacity structure of arrays: the update is one flat loop per frame the compiler can
+// vectorize, dead particles are swap-removed, and all of them are drawn as one VertexArray
+class ParticlePool {
+public:
+    static constexpr int CAPACITY = 4096;
+    static constexpr float SIZE = 8.f; // Square side in pixels
+
+    ParticlePool() : x(CAPACITY), y(CAPACITY), vx(CAPACITY), vy(CAPACITY), life(CAPACITY), color(CAPACITY),
+        vertices(PrimitiveType::Triangles, CAPACITY * 6) {
+        vertices.resize(0); // Storage stays reserved, later resizes never allocate
+    }
+
+    // Lifetime in seconds, alpha fades with it (1 second = solid at spawn); dropped when the pool is full
+    void spawn(Vector2f position, Vector2f velocity, float lifetime, Color c) {
+        if (count == CAPACITY) return;
+        x[count] = position.x;
+        y[count] = position.y;
+        vx[count] = velocity.x;
+        vy[count] = velocity.y;
+        life[count] = lifetime;
+        color[count] = c;
+        count++;
+    }
+
+    void update(float dt) {
+        float* px = x.data(); float* py = y.data(); float* pl = life.data();
+        const float* pvx = vx.data(); const float* pvy = vy.data();
+        for (int i = 0; i < count; i++) { // No branches, no aliasing between the arrays
+            px[i] += pvx[i] * dt;
+            py[i] += pvy[i] * dt;
+            pl[i] -= dt;
+        }
+        for (int i = 0; i < count;) { // Swap-remove dead particles, order does not matter
+            if (life[i] > 0) { i++; continue; }
+            count--;
+            x[i] = x[count]; y[i] = y[count]; vx[i] = vx[count]; vy[i] = vy[count];
+            life[i] = life[count]; color[i] = color[count];
+        }
+    }
+
+    void draw(RenderTarget& target) {
+        if (count == 0) return;
+        vertices.resize((size_t)count * 6);
+        for (int i = 0; i < count; i++) {
+            Color c = color[i];
+            c.a = static_cast<uint8_t>(min(1.0f, life[i]) * 255); // With time, increase the transparency (255 = solid, 0 = transparent)
+            Vector2f tl{ x[i], y[i] }, br{ x[i] + SIZE, y[i] + SIZE };
+            Vertex* v = &vertices[(size_t)i * 6];
+            v[0] = { tl, c, {} };
+            v[1] = { { br.x, tl.y }, c, {} };
+            v[2] = { br, c, {} };
+            v[3] = { tl, c, {} };
+            v[4] = { br, c, {} };
+            v[5] = { { tl.x, br.y }, c, {} };
+        }
+        target.draw(vertices);
+    }
+
+    int size() const { return count; }
+
+private:
+    vector<float> x, y, vx, vy, life;
+    vector<Color> color;
+    int count = 0;
+    VertexArray vertices;
+};
+
+// Floating Text (+1) for correct answer
+// Same pool idea: labels are laid out from the font's glyphs into one textured VertexArray
+// (outlines first, then fills), so any number of them is a single draw call with no Text objects
+class FloatingTextPool {
+public:
+    static constexpr int CAPACITY = 64;
+    static constexpr int MAX_LENGTH = 8; // Characters per label
+    static constexpr unsigned CHARACTER_SIZE = 30;
+    static constexpr float OUTLINE = 2.f;
+    static constexpr float SPEED = 100.f; // Pixels per second upwards
+
+    explicit FloatingTextPool(const Font& font) : font(font), vertices(PrimitiveType::Triangles, CAPACITY * MAX_LENGTH * 12) {
+        vertices.resize(0);
+    }
+
+    void spawn(const string& str, float px, float py) {
+        if (count == CAPACITY) return;
+        Label& l = labels[count++];
+        l.length = (int)min(str.size(), (size_t)MAX_LENGTH);
+        copy(str.begin(), str.begin() + l.length, l.text.begin());
+        l.x = px;
+        l.y = py;
+        l.life = 1.0f;
+    }
+
+    void update(float dt) {
+        for (int i = 0; i < count; i++) {
+            labels[i].y -= SPEED * dt; // Move Up
+            labels[i].life -= dt;
+        }
+        for (int i = 0; i < count;) {
+            if (labels[i].life > 0) i++;
+            else labels[i] = labels[--count];
+        }
+    }
+
+    void draw(RenderTarget& target) {
+        if (count == 0) return;
+        vertices.resize(0);
+        for (int pass = 0; pass < 2; pass++) { // 0 = outlines, 1 = fills on top
+            for (int i = 0; i < count; i++) {
+                const Label& l = labels[i];
+                uint8_t alpha = static_cast<uint8_t>(max(0.0f, min(1.0f, l.life)) * 255); // Fade out
+                Color c = pass == 0 ? Color(0, 0, 0, alpha) : Color(0, 255, 0, alpha);
+                float penX = l.x;
+                for (int k = 0; k < l.length; k++) {
+                    char32_t ch = (unsigned char)l.text[k];
+                    if (k > 0) penX += font.getKerning((unsigned char)l.text[k - 1], ch, CHARACTER_SIZE);
+                    const Glyph& glyph = font.getGlyph(ch, CHARACTER_SIZE, false, pass == 0 ? OUTLINE : 0.f);
+                    addGlyph(penX, l.y + CHARACTER_SIZE, glyph, c); // Baseline sits one character size down, like Text
+                    penX += font.getGlyph(ch, CHARACTER_SIZE, false).advance;
+                }
+            }
+        }
+        RenderStates states;
+        states.texture = &font.getTexture(CHARACTER_SIZE); // Fetched after getGlyph(), which may grow the page
+        target.draw(vertices, states);
+    }
+
+    int size() const { return count; }
+
+private:
+    struct Label {
+        array<char, MAX_LENGTH> text{};
+        int length = 0;
+        float x = 0, y = 0, life = 0;
+    };
+    const Font& font;
+    array<Label, CAPACITY> labels{};
+    int count = 0;
+    VertexArray vertices;
+
+    void addGlyph(float penX, float baseline, const Glyph& glyph, Color c) {
+        float left = penX + glyph.bounds.position.x, top = baseline + glyph.bounds.position.y;
+        float right = left + glyph.bounds.size.x, bottom = top + glyph.bounds.size.y;
+        float u0 = (float)glyph.textureRect.position.x, v0 = (float)glyph.textureRect.position.y;
+        float u1 = u0 + glyph.textureRect.size.x, v1 = v0 + glyph.textureRect.size.y;
+        vertices.append({ { left, top }, c, { u0, v0 } });
+        vertices.append({ { right, top }, c, { u1, v0 } });
+        vertices.append({ { right, bottom }, c, { u1, v1 } });
+        vertices.append({ { left, top }, c, { u0, v0 } });
+        vertices.append({ { right, bottom }, c, { u1, v1 } });
+        vertices.append({ { left, bottom }, c, { u0, v1 } });
+    }
+};
+
+// FNV-1a style fold, used to notice when anything drawn into a cached layer changed
+inline uint64_t foldHash(uint64_t hash, uint64_t value) { return (hash ^ value) * 1099511628211ull; }
+inline uint64_t foldHash(uint64_t hash, float value) { return foldHash(hash, (uint64_t)llround(value * 16.f)); }
+inline uint64_t foldHash(uint64_t hash, Vector2f v) { return foldHash(foldHash(hash, v.x), v.y); }
+inline uint64_t foldHash(uint64_t hash, Color c) { return foldHash(hash, ((uint64_t)c.r << 24) | ((uint64_t)c.g << 16) | ((uint64_t)c.b << 8) | c.a); }
+
+// Retained text: glyph quads (and the drop shadow) are built once and kept until the string or style changes
+class UiLabel : public Drawable, public Transformable {
+public:
+    UiLabel(const Font& font, const string& str = "", unsigned characterSize = 30, Color fill = Color::White)
+        : font(&font), characterSize(characterSize), fillColor(fill), vertices(PrimitiveType::Triangles) {
+        setString(str);
+    }
+
+    // UTF-8, like the question banks
+    void setString(string_view s) {
+        if (s == str) return;
+        str.assign(s);
+        codePoints = String::fromUtf8(str.begin(), str.end());
+        rebuild();
+    }
+    const string& getString() const { return str; }
+
+    void setCharacterSize(unsigned size) {
+        if (size == characterSize) return;
+        characterSize = size;
+        rebuild();
+    }
+    unsigned getCharacterSize() const { return characterSize; }
+
+    // Recolors the existing quads, no relayout
+    void setFillColor(Color c) {
+        if (c == fillColor) return;
+        fillColor = c;
+        for (size_t i = shadowVertices; i < vertices.getVertexCount(); i++) vertices[i].color = c;
+        revision++;
+    }
+
+    void setShadow(Color c, Vector2f offset) {
+        if (c == shadowColor && offset == shadowOffset) return;
+        shadowColor = c;
+        shadowOffset = offset;
+        rebuild();
+    }
+
+    // Fraction of the text bounds that sits on the position: (0.5, 0.5) centers, (1, 1) is bottom-right,
+    // 0 on an axis keeps the pen origin like a plain Text
+    void setAlignment(Vector2f a) {
+        alignment = a;
+        applyAlignment();
+    }
+
+    FloatRect getLocalBounds() const { return bounds; }
+
+    // Changes whenever the label would draw differently
+    uint64_t signature() const { return foldHash(foldHash(revision, getPosition()), getOrigin()); }
+
+protected:
+    void draw(RenderTarget& target, RenderStates states) const override {
+        if (vertices.getVertexCount() == 0) return;
+        states.transform *= getTransform();
+        states.texture = &font->getTexture(characterSize);
+        target.draw(vertices, states);
+    }
+
+private:
+    const Font* font;
+    string str;
+    String codePoints; // str decoded, what the glyphs are looked up by
+    unsigned characterSize;
+    Color fillColor;
+    Color shadowColor = Color::Transparent;
+    Vector2f shadowOffset;
+    Vector2f alignment;
+    VertexArray vertices;
+    size_t shadowVertices = 0; // Shadow quads come first so the fill draws on top
+    FloatRect bounds;
+    uint32_t revision = 0; // Bumped on every relayout or recolor
+
+    void rebuild() {
+        revision++;
+        vertices.clear();
+        if (shadowColor.a > 0) layout(shadowOffset, shadowColor);
+        shadowVertices = vertices.getVertexCount();
+        float minX = 0, minY = 0, maxX = 0, maxY = 0;
+        bool any = layout({ 0.f, 0.f }, fillColor, &minX, &minY, &maxX, &maxY);
+        bounds = any ? FloatRect({ minX, minY }, { maxX - minX, maxY - minY }) : FloatRect();
+        applyAlignment();
+    }
+
+    // Appends one quad per visible glyph, returns false when nothing was visible
+    bool layout(Vector2f offset, Color c, float* minX = nullptr, float* minY = nullptr, float* maxX = nullptr, float* maxY = nullptr) {
+        float penX = 0, baseline = (float)characterSize; // Baseline sits one character size down, like Text
+        char32_t previous = 0;
+        bool any = false;
+        for (char32_t ch : codePoints) {
+            if (ch == '\n') {
+                penX = 0;
+                baseline += font->getLineSpacing(characterSize);
+                previous = 0;
+                continue;
+            }
+            if (previous) penX += font->getKerning(previous, ch, characterSize);
+            previous = ch;
+            const Glyph& glyph = font->getGlyph(ch, characterSize, false);
+            if (ch != ' ' && ch != '\t') {
+                float left = penX + glyph.bounds.position.x, top = baseline + glyph.bounds.position.y;
+                float right = left + glyph.bounds.size.x, bottom = top + glyph.bounds.size.y;
+                float u0 = (float)glyph.textureRect.position.x, v0 = (float)glyph.textureRect.position.y;
+                float u1 = u0 + glyph.textureRect.size.x, v1 = v0 + glyph.textureRect.size.y;
+                if (minX) {
+                    if (!any) { *minX = left; *minY = top; *maxX = right; *maxY = bottom; }
+                    *minX = min(*minX, left); *minY = min(*minY, top);
+                    *maxX = max(*maxX, right); *maxY = max(*maxY, bottom);
+                }
+                any = true;
+                left += offset.x; right += offset.x; top += offset.y; bottom += offset.y;
+                vertices.append({ { left, top }, c, { u0, v0 } });
+                vertices.append({ { right, top }, c, { u1, v0 } });
+                vertices.append({ { right, bottom }, c, { u1, v1 } });
+                vertices.append({ { left, top }, c, { u0, v0 } });
+                vertices.append({ { right, bottom }, c, { u1, v1 } });
+                vertices.append({ { left, bottom }, c, { u0, v1 } });
+            }
+            penX += glyph.advance;
+        }
+        return any;
+    }
+
+    void applyAlignment() {
+        setOrigin({ alignment.x == 0 ? 0.f : bounds.position.x + bounds.size.x * alignment.x,
+                    alignment.y == 0 ? 0.f : bounds.position.y + bounds.size.y * alignment.y });
+    }
+};
+
+// A whole screen of static UI rendered into a texture, redrawn only when its signature changes
+// (hover, label text, volume, ...) and otherwise composited with a single full-screen quad
+class ScreenLayer {
+public:
+    bool create(Vector2u size) {
+        available = texture.resize(size);
+        if (available) sprite.emplace(texture.getTexture());
+        return available;
+    }
+    bool isAvailable() const { return available; }
+
+    // True when the caller has to draw the screen into target() and call finish()
+    bool needsRedraw(uint64_t signature) {
+        if (valid && signature == drawnSignature) return false;
+        drawnSignature = signature;
+        valid = true;
+        redraws++;
+        texture.clear(Color::Transparent);
+        return true;
+    }
+    RenderTexture& target() { return texture; }
+    void finish() { texture.display(); }
+
+    void draw(RenderTarget& window) const {
+        if (!sprite) return;
+        RenderStates states;
+        // The texture holds colors already multiplied by their alpha, blending them again would darken translucent buttons
+        states.blendMode = BlendMode(BlendMode::Factor::One, BlendMode::Factor::OneMinusSrcAlpha);
+        window.draw(*sprite, states);
+    }
+
+    uint64_t redrawCount() const { return redraws; }
+
+private:
+    RenderTexture texture;
+    optional<Sprite> sprite;
+    bool available = false;
+    bool valid = false;
+    uint64_t drawnSignature = 0;
+    uint64_t redraws = 0;
+};
+
+// --------------------------------------------------------
+//            FRAME SOURCES (Camera, Files, Synthetic)
+// --------------------------------------------------------
+
+// One frame plus where it sits in time
+struct TimedFrame {
+    Mat image;
+    double timestamp = 0.0; // Seconds since the source was opened (media time for files)
+    chrono::steady_clock::time_point captureTime; // Wall clock time the frame became available
+    uint64_t index = 0;
+    int label = -1; // Known finger count (synthetic or labelled files), -1 if unknown
+};
+
+// Real-time replays at the recorded rate, AsFastAsPossible hands out frames immediately (for throughput runs)
+enum class FramePacing {
+    RealTime,
+    AsFastAsPossible
+};
+
+// Anything the gesture pipeline can read frames from
+class FrameSource {
+public:
+    FramePacing pacing = FramePacing::RealTime;
+    bool loop = false; // Finite sources restart from the beginning instead of ending
+    cv::Size preferredSize; // Smallest frame the consumer needs, cameras pick the lowest mode that covers it (0x0 = driver default)
+
+    virtual ~FrameSource() = default;
+    virtual bool open() = 0;
+    virtual void close() {}
+    virtual bool read(TimedFrame& out) = 0; // False when the source failed or ran out of frames
+    virtual string describe() const = 0;
+
+protected:
+    chrono::steady_clock::time_point openedAt;
+
+    void markOpened() { openedAt = chrono::steady_clock::now(); }
+
+    // Finishes a frame: stamps it and, in real-time mode, waits until it is due
+    void stamp(TimedFrame& out, uint64_t index, double timestamp) {
+        if (pacing == FramePacing::RealTime) {
+            this_thread::sleep_until(openedAt + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(timestamp)));
+        }
+        out.index = index;
+        out.timestamp = timestamp;
+        out.captureTime = chrono::steady_clock::now();
+    }
+};
+
+// Live webcam, the device paces itself
+class CameraSource : public FrameSource {
+public:
+    explicit CameraSource(int device = -1) : device(device) {} // -1 tries device 0 then 1
+
+    bool open() override {
+        if (device >= 0) cap.open(device);
+        else {
+            cap.open(0); // Try default
+            if (!cap.isOpened()) cap.open(1); // Try secondary
+        }
+        if (!cap.isOpened()) return false;
+        cap.set(CAP_PROP_BUFFERSIZE, 1); // Keep only the newest frame in the driver queue (if supported)
+        negotiateResolution();
+        markOpened();
+        frameIndex = 0;
+        return true;
+    }
+    void close() override { if (cap.isOpened()) cap.release(); }
+    bool read(TimedFrame& out) override {
+        cap >> out.image; // Blocks on the driver
+        if (out.image.empty()) return false;
+        out.captureTime = chrono::steady_clock::now();
+        out.timestamp = chrono::duration<double>(out.captureTime - openedAt).count();
+        out.index = frameIndex++;
+        out.label = -1;
+        return true;
+    }
+    string describe() const override { return "camera:" + to_string(device); }
+
+private:
+    VideoCapture cap;
+    int device;
+
+    // Asks for the smallest common capture mode that still covers preferredSize, every extra pixel
+    // costs USB bandwidth and a copy per frame. Drivers may answer with a different mode, the
+    // pipeline clamps its ROI to whatever frame arrives.
+    void negotiateResolution() {
+        if (preferredSize.width <= 0 || preferredSize.height <= 0) return;
+        static const cv::Size modes[] = { {320, 240}, {640, 480}, {800, 600}, {1280, 720}, {1920, 1080} };
+        for (const cv::Size& mode : modes) {
+            if (mode.width >= preferredSize.width && mode.height >= preferredSize.height) {
+                cap.set(CAP_PROP_FRAME_WIDTH, mode.width);
+                cap.set(CAP_PROP_FRAME_HEIGHT, mode.height);
+                return;
+            }
+        }
+    }
+    uint64_t frameIndex = 0;
+};
+
+// Recorded video file, timestamps come from the file's frame rate
+class VideoFileSource : public FrameSource {
+public:
+    explicit VideoFileSource(const string& path) : path(path) {}
+
+    bool open() override {
+        cap.open(path);
+        if (!cap.isOpened()) return false;
+        fps = cap.get(CAP_PROP_FPS);
+        if (fps <= 0) fps = 30.0; // Some containers do not report a rate
+        markOpened();
+        frameIndex = 0;
+        return true;
+    }
+    void close() override { if (cap.isOpened()) cap.release(); }
+    bool read(TimedFrame& out) override {
+        cap >> out.image;
+        if (out.image.empty() && loop && frameIndex > 0) {
+            cap.open(path); // Rewind by reopening, works for every backend
+            cap >> out.image;
+        }
+        if (out.image.empty()) return false;
+        out.label = -1;
+        stamp(out, frameIndex, frameIndex / fps);
+        frameIndex++;
+        return true;
+    }
+    string describe() const override { return "video:" + path; }
+
+private:
+    VideoCapture cap;
+    string path;
+    double fps = 30.0;
+    uint64_t frameIndex = 0;
+};
+
+// Directory of still images played in name order
+// A "_f<N>" in a file name (e.g. frame0042_f3.png) marks the true finger count for that frame
+class ImageSequenceSource : public FrameSource {
+public:
+    ImageSequenceSource(const string& directory, double fps = 30.0) : directory(directory), fps(fps) {}
+
+    bool open() override {
+        files.clear();
+        error_code ec;
+        for (const auto& entry : filesystem::directory_iterator(directory, ec)) {
+            if (!entry.is_regular_file()) continue;
+            string ext = entry.path().extension().string();
+            transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+            if (ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp") files.push_back(entry.path().string());
+        }
+        sort(files.begin(), files.end());
+        if (files.empty()) return false;
+        markOpened();
+        frameIndex = 0;
+        return true;
+    }
+    bool read(TimedFrame& out) override {
+        size_t fileIdx = frameIndex;
+        if (fileIdx >= files.size()) {
+            if (!loop) return false;
+            fileIdx %= files.size();
+        }
+        out.image = imread(files[fileIdx], IMREAD_COLOR);
+        if (out.image.empty()) return false;
+        out.label = labelFromName(files[fileIdx]);
+        stamp(out, frameIndex, frameIndex / fps);
+        frameIndex++;
+        return true;
+    }
+    string describe() const override { return "images:" + directory; }
+
+private:
+    string directory;
+    double fps;
+    vector<string> files;
+    uint64_t frameIndex = 0;
+
+    static int labelFromName(const string& path) {
+        string name = filesystem::path(path).stem().string();
+        size_t pos = name.rfind("_f");
+        if (pos == string::npos || pos + 2 >= name.size()) return -1;
+        char digit = name[pos + 2];
+        return (digit >= '0' && digit <= '5') ? digit - '0' : -1;
+    }
+};
+
+// Procedurally drawn hand holding up N fingers, fully deterministic (no camera needed)
+// fingers < 0 cycles 0..5, holding each count for holdFrames frames
+class SyntheticHandSource : public FrameSource {
+public:
+    int fingers;
+    int holdFrames = 30;
+    int frameLimit; // 0 means endless
+    double fps = 30.0;
+    Size frameSize = Size(640, 480);
+
+    SyntheticHandSource(int fingers = -1, int frameLimit = 0) : fingers(fingers), frameLimit(frameLimit) {}
+
+    bool open() override {
+        markOpened();
+        frameIndex = 0;
+        return true;
+    }
+    bool read(TimedFrame& out) override {
+        if (frameLimit > 0 && frameIndex >= (uint64_t)frameLimit) {
+            if (!loop) return false;
+            frameIndex = 0;
+            markOpened();
+        }
+        int count = fingers >= 0 ? fingers : (int)((frameIndex / holdFrames) % 6);
+        render(out.image, count, frameIndex);
+        out.label = count;
+        stamp(out, frameIndex, frameIndex / fps);
+        frameIndex++;
+        return true;
+    }
+    string describe() const override { return "synthetic:" + to_string(fingers); }
+
+    // Draws the hand into image, the mirror flip in the pipeline puts it inside the ROI box
+    void render(Mat& image, int count, uint64_t seed) const {
+        image.create(frameSize, CV_8UC3);
+        image.setTo(Scalar(60, 40, 30)); // Dark blue-grey wall, far outside the skin range
+        if (count <= 0) return;
+
+        const Scalar skin(90, 140, 200); // BGR, H~14 S~140 V~200
+        // Small deterministic sway so consecutive frames are not identical
+        int sway = (int)(seed % 7) - 3;
+        Point palm(frameSize.width - 200 + sway, 260);
+        ellipse(image, palm, Size(60, 70), 0, 0, 360, skin, FILLED);
+        ellipse(image, palm + Point(0, 70), Size(40, 40), 0, 0, 360, skin, FILLED); // Wrist
+
+        // Fingers fan out over the top of the palm
+        for (int i = 0; i < count; i++) {
+            double angle = -CV_PI / 2 + (i - (count - 1) / 2.0) * 0.38; // ~22 degrees between fingers
+            Point2f dir((float)cos(angle), (float)sin(angle));
+            Point2f side(-dir.y, dir.x);
+            Point2f base((float)palm.x + dir.x * 45, (float)palm.y + dir.y * 50);
+            Point2f tip(base.x + dir.x * 90, base.y + dir.y * 90);
+            Point quad[4] = {
+                Point((int)(base.x + side.x * 11), (int)(base.y + side.y * 11)),
+                Point((int)(tip.x + side.x * 11), (int)(tip.y + side.y * 11)),
+                Point((int)(tip.x - side.x * 11), (int)(tip.y - side.y * 11)),
+                Point((int)(base.x - side.x * 11), (int)(base.y - side.y * 11))
+            };
+            fillConvexPoly(image, quad, 4, skin);
+            circle(image, Point((int)tip.x, (int)tip.y), 11, skin, FILLED);
+        }
+    }
+
+private:
+    uint64_t frameIndex = 0;
+};
+
+// Builds a source from a command line spec: camera[:N], video:<file>, images:<dir>, synthetic[:N]
+unique_ptr<FrameSource> makeFrameSource(const string& spec, FramePacing pacing) {
+    string kind = spec.substr(0, spec.find(':'));
+    string arg = spec.find(':') == string::npos ? "" : spec.substr(spec.find(':') + 1);
+    unique_ptr<FrameSource> source;
+    try {
+        if (kind == "camera") source = make_unique<CameraSource>(arg.empty() ? -1 : stoi(arg));
+        else if (kind == "video") source = make_unique<VideoFileSource>(arg);
+        else if (kind == "images") source = make_unique<ImageSequenceSource>(arg);
+        else if (kind == "synthetic") source = make_unique<SyntheticHandSource>(arg.empty() ? -1 : stoi(arg));
+    }
+    catch (...) {} // Bad number in the spec
+    if (source) source->pacing = pacing;
+    else cerr << "Error: Unknown frame source '" << spec << "'." << endl;
+    return source;
+}
+
+// --------------------------------------------------------
+//            NEW CLASS: HAND GESTURE TRACKER
+// --------------------------------------------------------
+
+
+// Lock-free single-producer/single-consumer slot that always holds the newest value (triple buffer)
+// The producer never waits for the consumer and the consumer never waits for the producer
+template <typename T>
+class LatestValueSlot {
+public:
+    // Producer side: write into the back buffer, then swap it with the middle one
+    void publish(const T& value) {
+        buffers[backIndex] = value;
+        uint8_t previous = middle.exchange(static_cast<uint8_t>(backIndex | FRESH_BIT), memory_order_acq_rel);
+        backIndex = previous & INDEX_MASK;
+    }
+
+    // Consumer side: take the middle buffer if something new was published, returns the newest value
+    const T& acquire() {
+        if (middle.load(memory_order_acquire) & FRESH_BIT) {
+            uint8_t previous = middle.exchange(frontIndex, memory_order_acq_rel);
+            frontIndex = previous & INDEX_MASK;
+        }
+        return buffers[frontIndex];
+    }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH_BIT = 0x4;
+    T buffers[3] = {};
+    atomic<uint8_t> middle{ 1 }; // Index of the shared buffer + "fresh" flag
+    uint8_t backIndex = 0; // Only touched by the producer
+    uint8_t frontIndex = 2; // Only touched by the consumer
+};
+
+// What the camera thread tells the game after every processed frame
+struct GestureState {
+    int detectedFingers = 0;
+    int stableCount = 0; // Finger count currently being held
+    float holdProgress = 0.0f; // 0..1 towards REQUIRED_HOLD_TIME
+    uint64_t lockSequence = 0; // Increments every time a gesture locks in
+    int lockedCount = 0; // Finger count of the last lock
+    bool calibrating = false; // Skin color calibration is collecting samples
+    chrono::steady_clock::time_point captureTime; // When the frame was grabbed from the camera
+    chrono::steady_clock::time_point lockCaptureTime; // Capture time of the frame that caused the last lock
+    chrono::steady_clock::time_point lockTime; // When the last lock happened
+};
+
+// --------------------------------------------------------
+//            LATENCY INSTRUMENTATION
+// --------------------------------------------------------
+
+// Fixed-bucket latency histogram: record() is a single relaxed atomic increment, no allocation
+// and no lock, so the camera thread can record while the render thread reads percentiles.
+// Buckets are 0.1 ms wide up to 10 ms, 1 ms up to 1 s, 10 ms up to 10 s, plus one overflow bucket
+class LatencyHistogram {
+public:
+    static constexpr int FINE = 100;
+    static constexpr int MEDIUM = 990;
+    static constexpr int COARSE = 900;
+    static constexpr int BUCKETS = FINE + MEDIUM + COARSE + 1;
+
+    void record(double ms) { buckets[bucketFor(ms)].fetch_add(1, memory_order_relaxed); }
+
+    uint64_t count() const {
+        uint64_t total = 0;
+        for (const auto& b : buckets) total += b.load(memory_order_relaxed);
+        return total;
+    }
+
+    // Upper edge of the bucket holding the p-th percentile (0..100), 0 when nothing was recorded
+    double percentile(double p) const {
+        uint64_t total = count();
+        if (total == 0) return 0;
+        uint64_t rank = max<uint64_t>(1, (uint64_t)ceil(total * p / 100.0));
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += buckets[i].load(memory_order_relaxed);
+            if (seen >= rank) return upperEdge(i);
+        }
+        return upperEdge(BUCKETS - 1);
+    }
+
+private:
+    array<atomic<uint32_t>, BUCKETS> buckets{};
+
+    static int bucketFor(double ms) {
+        if (!(ms > 0)) return 0; // Also catches NaN
+        if (ms < 10) return (int)(ms * 10);
+        if (ms < 1000) return FINE + (int)(ms - 10);
+        if (ms < 10000) return FINE + MEDIUM + (int)((ms - 1000) / 10);
+        return BUCKETS - 1;
+    }
+    static double upperEdge(int bucket) {
+        if (bucket < FINE) return (bucket + 1) * 0.1;
+        if (bucket < FINE + MEDIUM) return 10.0 + (bucket - FINE + 1);
+        if (bucket < FINE + MEDIUM + COARSE) return 1000.0 + (bucket - FINE - MEDIUM + 1) * 10.0;
+        return 10000.0; // Overflow, reported as the last edge
+    }
+};
+
+// Hops of the gesture-to-answer path, each one a histogram
+enum LatencyHop {
+    HOP_CAPTURE_TO_DETECT, // Frame grabbed -> finger count ready (every processed frame)
+    HOP_HOLD_TO_LOCK, // First frame showing the held count -> lock-in (includes REQUIRED_HOLD_TIME)
+    HOP_LOCK_TO_CONSUME, // Lock-in on the camera thread -> consumeTrigger() on the render thread
+    HOP_CONSUME_TO_FEEDBACK, // consumeTrigger() -> frame showing the result displayed
+    HOP_CAPTURE_TO_FEEDBACK, // Capture of the locking frame -> result on screen, end to end
+    HOP_COUNT
+};
+
+const char* const LATENCY_HOP_NAMES[HOP_COUNT] = {
+    "capture_to_detect", "hold_to_lock", "lock_to_consume", "consume_to_feedback", "capture_to_feedback"
+};
+
+struct LatencyReport {
+    LatencyHistogram hops[HOP_COUNT];
+
+    void record(LatencyHop hop, chrono::steady_clock::time_point from, chrono::steady_clock::time_point to) {
+        hops[hop].record(chrono::duration<double, milli>(to - from).count());
+    }
+
+    void print(ostream& out) const {
+        ostringstream table; // Formatted separately so out's flags are left alone
+        table << fixed << setprecision(1) << left << setw(22) << "Gesture latency (ms)" << right
+            << setw(9) << "count" << setw(10) << "p50" << setw(10) << "p95" << setw(10) << "p99" << "\n";
+        for (int hop = 0; hop < HOP_COUNT; hop++) {
+            table << left << setw(22) << LATENCY_HOP_NAMES[hop] << right << setw(9) << hops[hop].count()
+                << setw(10) << hops[hop].percentile(50) << setw(10) << hops[hop].percentile(95) << setw(10) << hops[hop].percentile(99) << "\n";
+        }
+        out << table.str() << flush;
+    }
+};
+
+// Camera preview drawn inside the game window: the mirrored ROI as a fixed size RGBA image,
+// so the texture it is uploaded to never has to be resized
+const int PREVIEW_SIZE = 160;
+struct GesturePreview {
+    vector<uint8_t> rgba; // PREVIEW_SIZE x PREVIEW_SIZE x 4, ready for Texture::update
+    uint64_t sequence = 0; // Increments with every new image, 0 = nothing published yet
+};
+
+enum class PreviewMode {
+    Embedded, // ROI thumbnail in a corner of the quiz screen
+    None // No copy, no overlays, detection only
+};
+
+// Decides which camera frames get a detection pass. Works on capture timestamps, so the
+// detection rate follows neither the render loop nor the camera's own frame rate, and a
+// frame processed late does not shift the frames after it
+class GestureScheduler {
+public:
+    double rateHz = 30.0; // 0 = every new camera frame
+
+    void reset() { nextDue = -1.0; }
+
+    bool due(double timestamp) {
+        if (rateHz <= 0) return true;
+        const double period = 1.0 / rateHz;
+        const double tolerance = period * 0.25; // Camera timestamps jitter, a frame slightly early still counts
+        if (nextDue >= 0 && timestamp + tolerance < nextDue) return false;
+        // Stay on the ideal grid, but restart it after a gap (stall, pause) instead of bursting to catch up
+        nextDue = (nextDue < 0 || timestamp - nextDue > period) ? timestamp + period : nextDue + period;
+        return true;
+    }
+
+private:
+    double nextDue = -1.0;
+};
+
+// Sliding-window majority vote over recent finger counts. A gesture locks once the window covers
+// `window` seconds of camera time and one non-zero count holds at least `threshold` of the votes,
+// so a single noisy frame no longer restarts the wait
+class FingerVoteFilter {
+public:
+    static constexpr int MAX_FINGERS = 5;
+    static constexpr int CAPACITY = 256; // Frames kept, 2 s at 120 Hz
+    static constexpr double MAX_FRAME_RATE = 120.0; // Fastest camera planned for when every frame is processed
+    double window = 0.2; // Seconds a gesture must be held
+    double threshold = 0.7; // Share of the frames in the window that must agree
+
+    void reset() {
+        head = 0;
+        size = 0;
+        tally.fill(0);
+    }
+
+    // Adds a frame, returns true when it locks a gesture (lockedCount() tells which)
+    bool update(double timestamp, int count) {
+        count = std::clamp(count, 0, MAX_FINGERS);
+        if (size == CAPACITY) pop();
+        samples[(head + size) % CAPACITY] = { timestamp, count };
+        size++;
+        tally[count]++;
+        // Keep exactly one frame at or beyond the window edge, that frame proves the window is covered
+        while (size > 1 && timestamp - samples[(head + 1) % CAPACITY].timestamp >= window) pop();
+
+        int leader = leadingCount();
+        // The newest frame must agree too, so a count the hand just left can't lock from its old votes.
+        // A full ring counts as covered, a camera faster than planned shortens the window instead of never locking
+        if (leader == 0 || leader != count || (heldFor(timestamp) < window && size < CAPACITY)) return false;
+        locked = leader;
+        lockedSince = samples[head].timestamp;
+        reset(); // A new lock needs a whole new window, no machine-gun triggering
+        return true;
+    }
+
+    // Non-zero count winning the vote with enough confidence, 0 when there is none
+    int leadingCount() const {
+        int leader = 0;
+        for (int c = 1; c <= MAX_FINGERS; c++) {
+            if (tally[c] > 0 && (leader == 0 || tally[c] > tally[leader])) leader = c;
+        }
+        return (leader > 0 && tally[leader] >= threshold * size) ? leader : 0;
+    }
+
+    // Longest window the ring holds at this many frames per second (0 = every camera frame)
+    static double maxWindow(double rateHz) { return (CAPACITY - 1) / (rateHz > 0 ? rateHz : MAX_FRAME_RATE); }
+
+    // Camera seconds covered by the window so far
+    double heldFor(double now) const { return size == 0 ? 0.0 : now - samples[head].timestamp; }
+    int lockedCount() const { return locked; }
+    double lockedWindowStart() const { return lockedSince; } // Oldest frame of the window that locked
+
+private:
+    struct Sample {
+        double timestamp;
+        int count;
+    };
+    array<Sample, CAPACITY> samples{};
+    array<int, MAX_FINGERS + 1> tally{};
+    int head = 0;
+    int size = 0;
+    int locked = 0;
+    double lockedSince = 0;
+
+    void pop() {
+        tally[samples[head].count]--;
+        head = (head + 1) % CAPACITY;
+        size--;
+    }
+};
+
+// The original stability rule: the same count on every frame for `window` seconds, any other
+// count restarts the wait. Only used as the baseline in --eval-gesture
+class ConsecutiveHoldFilter {
+public:
+    double window = 0.2;
+
+    void reset() { current = 0; }
+
+    bool update(double timestamp, int count) {
+        if (count == current && count > 0) {
+            if (timestamp - start >= window) {
+                locked = count;
+                start = timestamp;
+                return true;
+            }
+        }
+        else {
+            current = count;
+            start = timestamp;
+        }
+        return false;
+    }
+    int lockedCount() const { return locked; }
+
+private:
+    int current = 0;
+    int locked = 0;
+    double start = 0;
+};
+
+// --------------------------------------------------------
+//            SKIN SEGMENTATION KERNEL
+// --------------------------------------------------------
+
+// Skin means HSV inside (0,20,70)..(20,255,255), exactly what cvtColor(COLOR_BGR2HSV) + inRange produce,
+// but computed straight from BGR in one pass without the intermediate HSV image.
+// OpenCV's 8-bit HSV uses fixed point with 12 fractional bits:
+//   S = (diff * round(255*4096 / V) + 2048) >> 12
+//   H = (hraw * round(180*4096 / (6*diff)) + 2048) >> 12, +180 if negative
+// H only reaches 0..20 when red is the maximum channel (green max gives >= 30, blue max >= 90),
+// and then hraw = G - B. So a pixel is skin when:
+//   V == R, V >= 70, 0 <= (G-B)*hdiv + 2048 < 21*4096 and diff*sdiv + 2048 >= 20*4096
+
+namespace skin {
+    const int SHIFT = 12;
+    const int HALF = 1 << (SHIFT - 1);
+
+    struct DivTables {
+        int sdiv[256]; // round(255*4096 / v)
+        int hdiv[256]; // round(180*4096 / (6*diff))
+        DivTables() {
+            sdiv[0] = hdiv[0] = 0;
+            for (int i = 1; i < 256; i++) {
+                sdiv[i] = (int)lrint((255 << SHIFT) / (1.0 * i));
+                hdiv[i] = (int)lrint((180 << SHIFT) / (6.0 * i));
+            }
+        }
+    };
+    const DivTables tables;
+
+    inline bool isSkin(int b, int g, int r) {
+        int v = max(b, max(g, r));
+        if (v != r || v < 70) return false;
+        int diff = v - min(b, min(g, r));
+        if (diff * tables.sdiv[v] + HALF < (20 << SHIFT)) return false;
+        int h = (g - b) * tables.hdiv[diff] + HALF;
+        return h >= 0 && h < (21 << SHIFT);
+    }
+
+#if CV_SIMD128
+    // Hue and saturation tests for 4 pixels, recomputes the division tables in float
+    // (round(122880.f / d) and round(1044480.f / v) match the tables for every 8-bit input)
+    inline v_int32x4 hueSatMask(const v_int32x4& hraw, const v_int32x4& diff, const v_int32x4& v) {
+        const v_float32x4 one = v_setall_f32(1.0f);
+        v_int32x4 hdiv = v_round(v_setall_f32(122880.0f) / v_max(v_cvt_f32(diff), one));
+        v_int32x4 sdiv = v_round(v_setall_f32(1044480.0f) / v_max(v_cvt_f32(v), one));
+        v_int32x4 h = hraw * hdiv + v_setall_s32(HALF);
+        v_int32x4 s = diff * sdiv + v_setall_s32(HALF);
+        return (h >= v_setall_s32(0)) & (h < v_setall_s32(21 << SHIFT)) & (s >= v_setall_s32(20 << SHIFT));
+    }
+
+    // 16 pixels of BGR in, 16 mask bytes (0 or 255) out
+    inline v_uint8x16 segment16(const uchar* bgr) {
+        v_uint8x16 b, g, r;
+        v_load_deinterleave(bgr, b, g, r);
+        v_uint8x16 vmax = v_max(v_max(b, g), r);
+        v_uint8x16 diff = vmax - v_min(v_min(b, g), r);
+        v_uint8x16 candidate = (vmax == r) & (vmax >= v_setall_u8(70));
+
+        v_uint16x8 g16[2], b16[2], d16[2], v16[2];
+        v_expand(g, g16[0], g16[1]);
+        v_expand(b, b16[0], b16[1]);
+        v_expand(diff, d16[0], d16[1]);
+        v_expand(vmax, v16[0], v16[1]);
+        v_int16x8 packed[2];
+        for (int half = 0; half < 2; half++) {
+            v_int32x4 h32[2];
+            v_uint32x4 d32[2], v32[2];
+            v_expand(v_reinterpret_as_s16(g16[half]) - v_reinterpret_as_s16(b16[half]), h32[0], h32[1]);
+            v_expand(d16[half], d32[0], d32[1]);
+            v_expand(v16[half], v32[0], v32[1]);
+            packed[half] = v_pack(hueSatMask(h32[0], v_reinterpret_as_s32(d32[0]), v_reinterpret_as_s32(v32[0])),
+                                  hueSatMask(h32[1], v_reinterpret_as_s32(d32[1]), v_reinterpret_as_s32(v32[1])));
+        }
+        return candidate & v_reinterpret_as_u8(v_pack(packed[0], packed[1]));
+    }
+#endif
+}
+
+// Fused replacement for cvtColor(COLOR_BGR2HSV) + inRange((0,20,70), (20,255,255)), bit exact
+void segmentSkin(const Mat& bgr, Mat& mask) {
+    mask.create(bgr.size(), CV_8UC1);
+    for (int y = 0; y < bgr.rows; y++) {
+        const uchar* src = bgr.ptr<uchar>(y);
+        uchar* dst = mask.ptr<uchar>(y);
+        int x = 0;
+#if CV_SIMD128
+        for (; x <= bgr.cols - 16; x += 16) v_store(dst + x, skin::segment16(src + 3 * x));
+#endif
+        for (; x < bgr.cols; x++) dst[x] = skin::isSkin(src[3 * x], src[3 * x + 1], src[3 * x + 2]) ? 255 : 0;
+    }
+}
+
+// The original two-call path, kept as the reference for --verify-gesture and the benchmark
+void segmentSkinReference(const Mat& bgr, Mat& hsv, Mat& mask) {
+    cvtColor(bgr, hsv, COLOR_BGR2HSV);
+    inRange(hsv, Scalar(0, 20, 70), Scalar(20, 255, 255), mask);
+}
+
+// --------------------------------------------------------
+//            BIT-PACKED MASK MORPHOLOGY
+// --------------------------------------------------------
+
+// Binary mask stored at 1 bit per pixel: bit (x % 64) of word (x / 64) in each row is pixel x
+// Bits past the width in the last word of a row are always kept at 0
+struct BitMask {
+    int width = 0;
+    int height = 0;
+    int wordsPerRow = 0;
+    vector<uint64_t> words;
+
+    void create(int w, int h) {
+        if (w == width && h == height) return;
+        width = w;
+        height = h;
+        wordsPerRow = (w + 63) / 64;
+        words.assign((size_t)wordsPerRow * h, 0);
+    }
+    uint64_t* row(int y) { return words.data() + (size_t)y * wordsPerRow; }
+    const uint64_t* row(int y) const { return words.data() + (size_t)y * wordsPerRow; }
+    // Valid pixel bits of the last word in a row
+    uint64_t lastWordMask() const { return (width % 64) == 0 ? ~0ULL : (1ULL << (width % 64)) - 1; }
+};
+
+// Expands a bit mask back to the 0/255 bytes OpenCV functions expect
+void unpackMask(const BitMask& bits, Mat& mask) {
+    // Each entry turns 8 mask bits into 8 bytes of 0x00/0xFF
+    static const auto table = [] {
+        array<uint64_t, 256> t{};
+        for (int i = 0; i < 256; i++)
+            for (int bit = 0; bit < 8; bit++)
+                if (i & (1 << bit)) t[i] |= 0xFFULL << (8 * bit);
+        return t;
+    }();
+    mask.create(bits.height, bits.width, CV_8UC1);
+    for (int y = 0; y < bits.height; y++) {
+        const uint64_t* src = bits.row(y);
+        uchar* dst = mask.ptr<uchar>(y);
+        int x = 0;
+        for (; x + 8 <= bits.width; x += 8) {
+            uint64_t bytes = table[(src[x / 64] >> (x % 64)) & 0xFF];
+            memcpy(dst + x, &bytes, 8);
+        }
+        for (; x < bits.width; x++) dst[x] = ((src[x / 64] >> (x % 64)) & 1) ? 255 : 0;
+    }
+}
+
+// Square erosion/dilation on BitMask with word-wide shifts and AND/OR, 64 pixels per operation
+// Borders follow OpenCV's defaults: erosion treats outside pixels as set, dilation as clear
+class BinaryMorphology {
+public:
+    // Same as cv::erode with a (2*radius+1)^2 rectangle
+    void erode(BitMask& m, int radius) {
+        for (int i = 0; i < radius; i++) horizontalPass(m, true);
+        for (int i = 0; i < radius; i++) verticalPass(m, true);
+    }
+
+    // Same as cv::dilate with a (2*radius+1)^2 rectangle
+    void dilate(BitMask& m, int radius) {
+        for (int i = 0; i < radius; i++) horizontalPass(m, false);
+        for (int i = 0; i < radius; i++) verticalPass(m, false);
+    }
+
+private:
+    vector<uint64_t> previous, current; // Row copies for the vertical pass, reused between frames
+
+    // Each pixel combined with its left and right neighbour
+    static void horizontalPass(BitMask& m, bool isErode) {
+        const uint64_t border = isErode ? ~0ULL : 0ULL;
+        const uint64_t tailMask = m.lastWordMask();
+        const int n = m.wordsPerRow;
+        for (int y = 0; y < m.height; y++) {
+            uint64_t* row = m.row(y);
+            row[n - 1] = (row[n - 1] & tailMask) | (border & ~tailMask); // Padding bits act as border pixels
+            uint64_t carry = border >> 63; // Top bit of the word to the left
+            for (int w = 0; w < n; w++) {
+                uint64_t cur = row[w];
+                uint64_t next = (w + 1 < n) ? row[w + 1] : border;
+                uint64_t left = (cur << 1) | carry; // Pixel x-1 moved to bit x
+                uint64_t right = (cur >> 1) | (next << 63); // Pixel x+1 moved to bit x
+                row[w] = isErode ? (cur & left & right) : (cur | left | right);
+                carry = cur >> 63;
+            }
+            row[n - 1] &= tailMask;
+        }
+    }
+
+    // Each pixel combined with the pixels above and below
+    void verticalPass(BitMask& m, bool isErode) {
+        const int n = m.wordsPerRow;
+        const uint64_t border = isErode ? ~0ULL : 0ULL;
+        const uint64_t tailMask = m.lastWordMask();
+        previous.assign(n, border);
+        current.resize(n);
+        for (int y = 0; y < m.height; y++) {
+            uint64_t* row = m.row(y);
+            const uint64_t* below = (y + 1 < m.height) ? m.row(y + 1) : nullptr;
+            copy(row, row + n, current.begin());
+            for (int w = 0; w < n; w++) {
+                uint64_t down = below ? below[w] : border;
+                row[w] = isErode ? (previous[w] & current[w] & down) : (previous[w] | current[w] | down);
+            }
+            row[n - 1] &= tailMask;
+            swap(previous, current);
+        }
+    }
+};
+
+// segmentSkin() writing straight into a bit mask, 8x less memory written than the byte mask
+void segmentSkinPacked(const Mat& bgr, BitMask& bits) {
+    bits.create(bgr.cols, bgr.rows);
+    for (int y = 0; y < bgr.rows; y++) {
+        const uchar* src = bgr.ptr<uchar>(y);
+        uint64_t* dst = bits.row(y);
+        fill(dst, dst + bits.wordsPerRow, 0ULL);
+        int x = 0;
+#if CV_SIMD128
+        for (; x <= bgr.cols - 16; x += 16) {
+            uint64_t lanes = (uint64_t)(unsigned)v_signmask(skin::segment16(src + 3 * x)); // One bit per pixel
+            dst[x / 64] |= lanes << (x % 64); // 16 divides 64, so a group never straddles two words
+        }
+#endif
+        for (; x < bgr.cols; x++)
+            if (skin::isSkin(src[3 * x], src[3 * x + 1], src[3 * x + 2])) dst[x / 64] |= 1ULL << (x % 64);
+    }
+}
+
+// dst = every pixel of src flipped, padding bits stay clear
+void invertMask(const BitMask& src, BitMask& dst) {
+    dst.create(src.width, src.height);
+    for (int y = 0; y < src.height; y++) {
+        const uint64_t* in = src.row(y);
+        uint64_t* out = dst.row(y);
+        for (int w = 0; w < src.wordsPerRow; w++) out[w] = ~in[w];
+        out[src.wordsPerRow - 1] &= src.lastWordMask();
+    }
+}
+
+// The original OpenCV cleanup, kept as the reference for --verify-gesture and the benchmark
+void cleanMaskReference(Mat& mask) {
+    erode(mask, mask, Mat(), Point(-1, -1), 2);
+    dilate(mask, mask, Mat(), Point(-1, -1), 2);
+    GaussianBlur(mask, mask, Size(5, 5), 0);
+}
+
+// Bit-packed segmentation + cleanup, the path GesturePipeline runs
+void cleanMaskPacked(const Mat& bgr, BitMask& bits, BinaryMorphology& morphology, Mat& mask) {
+    segmentSkinPacked(bgr, bits);
+    morphology.erode(bits, 2);
+    morphology.dilate(bits, 2);
+    morphology.dilate(bits, 2); // Stands in for the blur
+    unpackMask(bits, mask);
+}
+
+// --------------------------------------------------------
+//            CALIBRATED SKIN COLOR TABLE
+// --------------------------------------------------------
+
+// BGR -> skin as one bit per 4x4x4 color cell: 64x64x64 bits = 32 KB, small enough to stay in L2.
+// Built from color statistics of the user's own hand under the site's own lighting instead of
+// fixed HSV bounds, so segmentation is one lookup per pixel and no color conversion.
+// Skin and background counts are kept next to the bits: a new calibration halves the old counts
+// and adds to them, so the table follows lighting changes without starting from scratch
+class SkinColorTable {
+public:
+    static constexpr int LEVELS = 64;
+    static constexpr int CELLS = LEVELS * LEVELS * LEVELS;
+    static constexpr uint32_t MIN_SKIN_SAMPLES = 4; // Cells seen less often are noise
+    static constexpr double SKIN_BIAS = 2.0; // Skin when P(cell | skin) > SKIN_BIAS * P(cell | background)
+
+    bool ready = false; // False until calibrated or loaded, callers then use the HSV rule
+
+    SkinColorTable() : skinCounts(CELLS, 0), backgroundCounts(CELLS, 0) {}
+
+    static int cell(int b, int g, int r) { return ((b >> 2) << 12) | ((g >> 2) << 6) | (r >> 2); }
+    bool isSkin(int b, int g, int r) const {
+        int c = cell(b, g, r);
+        return (bits[c >> 6] >> (c & 63)) & 1;
+    }
+    // The 64 cells of one (b, g) pair, bit i = red level i
+    uint64_t redLevels(int b, int g) const { return bits[((b >> 2) << 6) | (g >> 2)]; }
+
+    // Counts every pixel of bgr as skin or background (pixels in neither mask are skipped)
+    void addSamples(const Mat& bgr, const BitMask& skin, const BitMask& background) {
+        for (int y = 0; y < bgr.rows; y++) {
+            const uchar* src = bgr.ptr<uchar>(y);
+            const uint64_t* skinRow = skin.row(y);
+            const uint64_t* backgroundRow = background.row(y);
+            for (int x = 0; x < bgr.cols; x++) {
+                uint64_t bit = 1ULL << (x % 64);
+                int c = cell(src[3 * x], src[3 * x + 1], src[3 * x + 2]);
+                if (skinRow[x / 64] & bit) add(skinCounts, skinTotal, c);
+                else if (backgroundRow[x / 64] & bit) add(backgroundCounts, backgroundTotal, c);
+            }
+        }
+    }
+
+    // Old statistics count half from now on, called when a new calibration starts
+    void decay() {
+        halve(skinCounts, skinTotal);
+        halve(backgroundCounts, backgroundTotal);
+    }
+
+    // Recomputes the bits from the counts (about 262K cells, well under a millisecond)
+    void rebuild() {
+        bits.fill(0);
+        double ratio = backgroundTotal > 0 ? SKIN_BIAS * (double)skinTotal / backgroundTotal : 0.0;
+        for (int c = 0; c < CELLS; c++) {
+            uint32_t s = skinCounts[c];
+            if (s >= MIN_SKIN_SAMPLES && s > ratio * backgroundCounts[c]) bits[c >> 6] |= 1ULL << (c & 63);
+        }
+        ready = skinTotal > 0;
+    }
+
+    // Binary file: magic, cell count, then both count arrays (the bits are rebuilt on load)
+    bool save(const string& path) const {
+        ofstream out(path, ios::binary);
+        if (!out.is_open()) return false;
+        uint32_t header[2] = { FILE_MAGIC, (uint32_t)CELLS };
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(skinCounts.data()), skinCounts.size() * sizeof(uint32_t));
+        out.write(reinterpret_cast<const char*>(backgroundCounts.data()), backgroundCounts.size() * sizeof(uint32_t));
+        return (bool)out;
+    }
+
+    bool load(const string& path) {
+        ifstream in(path, ios::binary);
+        if (!in.is_open()) return false;
+        uint32_t header[2] = {};
+        in.read(reinterpret_cast<char*>(header), sizeof(header));
+        if (!in || header[0] != FILE_MAGIC || header[1] != (uint32_t)CELLS) return false;
+        in.read(reinterpret_cast<char*>(skinCounts.data()), skinCounts.size() * sizeof(uint32_t));
+        in.read(reinterpret_cast<char*>(backgroundCounts.data()), backgroundCounts.size() * sizeof(uint32_t));
+        if (!in) {
+            clear();
+            return false;
+        }
+        skinTotal = backgroundTotal = 0;
+        for (int c = 0; c < CELLS; c++) {
+            skinTotal += skinCounts[c];
+            backgroundTotal += backgroundCounts[c];
+        }
+        rebuild();
+        return true;
+    }
+
+    void clear() {
+        fill(skinCounts.begin(), skinCounts.end(), 0);
+        fill(backgroundCounts.begin(), backgroundCounts.end(), 0);
+        skinTotal = backgroundTotal = 0;
+        bits.fill(0);
+        ready = false;
+    }
+
+private:
+    static constexpr uint32_t FILE_MAGIC = 0x31544B53; // "SKT1"
+    array<uint64_t, CELLS / 64> bits{};
+    vector<uint32_t> skinCounts, backgroundCounts; // Allocated once, 1 MB each
+    uint64_t skinTotal = 0, backgroundTotal = 0;
+
+    static void add(vector<uint32_t>& counts, uint64_t& total, int c) {
+        if (counts[c] == UINT32_MAX) return;
+        counts[c]++;
+        total++;
+    }
+    static void halve(vector<uint32_t>& counts, uint64_t& total) {
+        total = 0;
+        for (uint32_t& n : counts) {
+            n >>= 1;
+            total += n;
+        }
+    }
+};
+
+// Table-driven segmentation straight into the packed mask: one lookup per pixel
+void segmentSkinTable(const Mat& bgr, BitMask& bits, const SkinColorTable& table) {
+    bits.create(bgr.cols, bgr.rows);
+    for (int y = 0; y < bgr.rows; y++) {
+        const uchar* src = bgr.ptr<uchar>(y);
+        uint64_t* dst = bits.row(y);
+        for (int w = 0; w < bits.wordsPerRow; w++) {
+            int end = min(bgr.cols, (w + 1) * 64);
+            uint64_t word = 0;
+            for (int x = w * 64; x < end; x++) {
+                const uchar* p = src + 3 * x;
+                word |= ((table.redLevels(p[0], p[1]) >> (p[2] >> 2)) & 1) << (x % 64);
+            }
+            dst[w] = word;
+        }
+    }
+}
+
+// --------------------------------------------------------
+//            LARGEST BLOB EXTRACTION
+// --------------------------------------------------------
+
+// Finds the 8-connected blob in a BitMask whose outer border has the largest polygon area and keeps only that border
+// 1. Runs of set bits per row are labelled with union-find (no label image, no hierarchy)
+// 2. The traced polygon always fits the blob's bounding box (holes included, so pixel count is no bound),
+//    so blobs whose box is too small to beat minArea or the best area so far are rejected before tracing
+// 3. Outer borders are followed from each blob's top-left pixel (Moore neighbour tracing)
+//    and stored with straight runs collapsed, like CHAIN_APPROX_SIMPLE
+class LargestBlobExtractor {
+public:
+    vector<Point> contour; // Outer border of the largest blob, ROI coordinates
+    double area = 0; // Polygon area of contour (same as contourArea)
+    int pixelCount = 0; // Pixels in the largest blob
+    cv::Rect bounds; // Bounding box of the largest blob
+
+    void reserve(int width, int height) {
+        runs.reserve((size_t)height * (width / 2 + 1));
+        counts.reserve(runs.capacity());
+        boxes.reserve(runs.capacity());
+        contour.reserve(4 * (width + height));
+        candidate.reserve(contour.capacity());
+    }
+
+    // Returns true when a blob with more than minArea polygon area was found. The winner is the blob whose outer
+    // border has the largest polygon area, the same pick as contourArea over findContours (ties: first in raster order)
+    bool extract(const BitMask& m, double minArea) {
+        contour.clear();
+        area = 0;
+        pixelCount = 0;
+        bounds = cv::Rect();
+        if (!labelRuns(m)) return false;
+
+        // The border runs through pixel centres, so its polygon area is at most (box width - 1) * (box height - 1)
+        int best = -1;
+        for (size_t i = 0; i < runs.size(); i++) {
+            if (runs[i].parent != (int)i) continue; // Roots only, a root is its blob's first run in raster order
+            double boxArea = (double)(boxes[i].maxX - boxes[i].minX) * (boxes[i].maxY - boxes[i].minY);
+            if (boxArea <= minArea || boxArea <= area) continue;
+            candidate.clear();
+            trace(m, Point(runs[i].x0, runs[i].y), candidate);
+            double candidateArea = polygonArea(candidate);
+            if (candidateArea > area) {
+                area = candidateArea;
+                best = (int)i;
+                contour.swap(candidate);
+            }
+        }
+        if (best < 0) return false;
+        pixelCount = counts[best];
+        const Box& box = boxes[best];
+        bounds = cv::Rect(box.minX, box.minY, box.maxX - box.minX + 1, box.maxY - box.minY + 1);
+        return area > minArea;
+    }
+
+private:
+    struct Run {
+        int y, x0, x1; // Inclusive pixel range
+        int parent;
+    };
+    vector<Run> runs;
+    struct Box {
+        int minX, minY, maxX, maxY; // Inclusive
+    };
+    vector<int> counts; // Pixel count per root run
+    vector<Box> boxes; // Bounding box per root run
+    vector<Point> candidate; // Border being traced, swapped into contour when it wins
+
+    int find(int i) {
+        while (runs[i].parent != i) {
+            runs[i].parent = runs[runs[i].parent].parent; // Path halving
+            i = runs[i].parent;
+        }
+        return i;
+    }
+
+    static int nextSet(const uint64_t* row, int x, int width, int words) {
+        int w = x / 64;
+        uint64_t bits = row[w] & (~0ULL << (x % 64));
+        while (bits == 0) {
+            if (++w >= words) return width;
+            bits = row[w];
+        }
+        return w * 64 + countr_zero(bits);
+    }
+
+    static int nextClear(const uint64_t* row, int x, int width, int words) {
+        int w = x / 64;
+        uint64_t bits = ~row[w] & (~0ULL << (x % 64));
+        while (bits == 0) {
+            if (++w >= words) return width;
+            bits = ~row[w];
+        }
+        return min(width, w * 64 + countr_zero(bits));
+    }
+
+    // Splits rows into runs, joins runs that touch (8-connected), sums pixels and bounding boxes per blob. False when the mask is empty
+    bool labelRuns(const BitMask& m) {
+        runs.clear();
+        size_t previousRowStart = 0, previousRowEnd = 0;
+        for (int y = 0; y < m.height; y++) {
+            const uint64_t* row = m.row(y);
+            size_t rowStart = runs.size();
+            for (int x = nextSet(row, 0, m.width, m.wordsPerRow); x < m.width; x = nextSet(row, x, m.width, m.wordsPerRow)) {
+                int end = nextClear(row, x, m.width, m.wordsPerRow);
+                int index = (int)runs.size();
+                runs.push_back({ y, x, end - 1, index });
+                x = end;
+            }
+            // Two-pointer sweep over the previous row's runs
+            size_t p = previousRowStart;
+            for (size_t c = rowStart; c < runs.size(); c++) {
+                while (p < previousRowEnd && runs[p].x1 < runs[c].x0 - 1) p++;
+                for (size_t q = p; q < previousRowEnd && runs[q].x0 <= runs[c].x1 + 1; q++) {
+                    int a = find((int)q), b = find((int)c);
+                    if (a != b) runs[max(a, b)].parent = min(a, b); // Lower index stays root
+                }
+            }
+            previousRowStart = rowStart;
+            previousRowEnd = runs.size();
+        }
+        if (runs.empty()) return false;
+
+        // Pixel counts and boxes accumulate on the roots, every parent points straight at its root afterwards
+        counts.assign(runs.size(), 0);
+        boxes.resize(runs.size());
+        for (size_t i = 0; i < runs.size(); i++) {
+            int root = find((int)i);
+            runs[i].parent = root;
+            counts[root] += runs[i].x1 - runs[i].x0 + 1;
+            Box& box = boxes[root];
+            if (root == (int)i) box = { runs[i].x0, runs[i].y, runs[i].x1, runs[i].y }; // Roots come first in their blob
+            box.minX = min(box.minX, runs[i].x0);
+            box.maxX = max(box.maxX, runs[i].x1);
+            box.maxY = runs[i].y; // Raster order
+        }
+        return true;
+    }
+
+    static bool isSet(const BitMask& m, int x, int y) {
+        if (x < 0 || y < 0 || x >= m.width || y >= m.height) return false;
+        return (m.row(y)[x / 64] >> (x % 64)) & 1;
+    }
+
+    // Moore neighbour tracing, clockwise on screen, stops when the first step repeats (Jacob's criterion)
+    void trace(const BitMask& m, Point start, vector<Point>& border) const {
+        static const int DX[8] = { 1, 1, 0, -1, -1, -1, 0, 1 }; // E, SE, S, SW, W, NW, N, NE
+        static const int DY[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+        static const int DIRECTION_OF[3][3] = { { 5, 6, 7 }, { 4, -1, 0 }, { 3, 2, 1 } }; // [dy+1][dx+1]
+
+        Point current = start;
+        int backtrack = 4; // Came from the west: the pixel left of the top-left pixel is empty
+        Point second(-1, -1);
+        int lastStep = -1;
+        border.push_back(start);
+        size_t limit = 4 * (size_t)(m.width + 2) * (m.height + 2); // Guard, a border never visits a pixel more than 4 times
+        for (size_t steps = 0; steps < limit; steps++) {
+            int step = -1;
+            for (int k = 1; k <= 8; k++) {
+                int dir = (backtrack + k) % 8;
+                if (isSet(m, current.x + DX[dir], current.y + DY[dir])) {
+                    step = dir;
+                    int emptyDir = (backtrack + k - 1) % 8; // Last empty neighbour checked
+                    Point next(current.x + DX[dir], current.y + DY[dir]);
+                    Point empty(current.x + DX[emptyDir], current.y + DY[emptyDir]);
+                    backtrack = DIRECTION_OF[empty.y - next.y + 1][empty.x - next.x + 1];
+                    break;
+                }
+            }
+            if (step < 0) return; // Single pixel blob
+            Point next(current.x + DX[step], current.y + DY[step]);
+            if (current == start) {
+                if (second.x < 0) second = next;
+                else if (next == second) break; // Back where we started, going the same way
+            }
+            // Only corners are kept: a point is replaced while the direction stays the same
+            if (step == lastStep && border.size() > 1) border.back() = next;
+            else border.push_back(next);
+            lastStep = step;
+            current = next;
+        }
+        if (border.size() > 1 && border.back() == start) border.pop_back(); // Closed polygon, start is implied
+    }
+
+    // Shoelace formula in integers, same value contourArea() returns
+    static double polygonArea(const vector<Point>& border) {
+        long long twice = 0;
+        for (size_t i = 0, n = border.size(); i < n; i++) {
+            const Point& a = border[i];
+            const Point& b = border[(i + 1) % n];
+            twice += (long long)a.x * b.y - (long long)b.x * a.y;
+        }
+        return llabs(twice) / 2.0;
+    }
+};
+
+// The original contour stage on a byte mask (findContours RETR_TREE, contourArea on every contour,
+// copy of the winner, acos angle test), kept as the reference for --verify-gesture and the benchmark
+int countFingersReference(Mat& mask) {
+    vector<vector<Point>> contours;
+    findContours(mask, contours, RETR_TREE, CHAIN_APPROX_SIMPLE);
+    if (contours.empty()) return 0;
+    size_t maxIdx = 0;
+    double maxArea = 0;
+    for (size_t i = 0; i < contours.size(); i++) {
+        double area = contourArea(contours[i]);
+        if (area > maxArea) {
+            maxArea = area;
+            maxIdx = i;
+        }
+    }
+    if (maxArea <= 3000) return 0;
+    vector<Point> maxContour = contours[maxIdx];
+    vector<int> hullIndices;
+    convexHull(maxContour, hullIndices, false);
+    int count = 0;
+    if (hullIndices.size() > 3) {
+        vector<Vec4i> defects;
+        convexityDefects(maxContour, hullIndices, defects);
+        for (const auto& v : defects) {
+            if ((float)v[3] / 256.0f <= 10) continue;
+            Point pStart = maxContour[v[0]];
+            Point pEnd = maxContour[v[1]];
+            Point pFar = maxContour[v[2]];
+            double a = norm(pEnd - pStart);
+            double b = norm(pFar - pStart);
+            double c = norm(pFar - pEnd);
+            double angle = acos((b * b + c * c - a * a) / (2 * b * c)) * 180 / CV_PI;
+            if (angle <= 90) count++;
+        }
+    }
+    return min(count + 1, 5);
+}
+
+// Finger counting, one method per stage so each can be timed on its own (see --bench-gesture)
+enum GestureStage {
+    STAGE_ROI,
+    STAGE_FLIP,
+    STAGE_SEGMENT,
+    STAGE_MORPHOLOGY,
+    STAGE_SMOOTH,
+    STAGE_EXTRACT,
+    STAGE_HULL,
+    STAGE_DEFECTS,
+    STAGE_CLASSIFY,
+    STAGE_COUNT
+};
+
+const char* const GESTURE_STAGE_NAMES[STAGE_COUNT] = {
+    "roi", "flip", "segment", "morphology", "smooth", "extract", "hull", "defects", "classify"
+};
+
+class GesturePipeline {
+public:
+    // Region of Interest (ROI) - User puts hand in a box
+    // Using a fixed box ensures better lighting consistency
+    // Rects are in mirrored (what the user sees) coordinates
+    cv::Rect searchRect = cv::Rect(50, 50, 300, 300);
+    cv::Rect roiRect = searchRect; // Region processed by the last frame
+    // Tracking mode: the ROI follows the hand's bounding box from frame to frame and grows back to
+    // searchRect when the hand is lost, so pixel work scales with the hand instead of the box
+    bool tracking = false;
+    const cv::Size MAX_ROI_SIZE = cv::Size(480, 480);
+    const int TRACK_MARGIN = 24; // Pixels around the hand, room for it to move before the next frame
+    // Processing scale divisor (1, 2 or 4): the ROI is downsampled once and every later stage
+    // runs on 1/scale^2 of the pixels, thresholds below are given at full resolution and rescaled
+    int scale = 1;
+    const double MIN_HAND_AREA = 3000; // Square pixels
+    const int MIN_DEFECT_DEPTH = 10; // Pixels
+    const int CLEANUP_RADIUS = 2; // Morphology radius (5x5 kernel)
+
+    // Stage outputs, each stage reads what the previous one left here
+    // All of them are members so their memory is reused frame after frame instead of reallocated
+    Mat frame; // Camera frame as captured (never modified, only the ROI gets mirrored)
+    Mat roiBuffer; // MAX_ROI_SIZE backing store, so a changing ROI size never reallocates
+    Mat roi; // Mirrored (and downsampled) ROI, view into roiBuffer
+    cv::Rect sourceRect; // roiRect in unmirrored frame coordinates
+    BitMask bits;
+    BinaryMorphology morphology;
+    LargestBlobExtractor extractor; // extractor.contour is the hand, read in place and never copied
+    const SkinColorTable* skinTable = nullptr; // Calibrated classifier, owned by the caller
+    double maxArea = 0; // In full resolution square pixels
+    bool handFound = false;
+    cv::Rect handRect; // Hand's bounding box in full resolution (mirrored) frame coordinates
+    vector<int> hullIndices;
+    vector<Vec4i> defects;
+    int detectedFingers = 0;
+    uint64_t frameAllocations = 0; // Heap allocations made by the last process() (GESTURE_COUNT_ALLOCATIONS builds)
+
+    GesturePipeline() {
+        allocateBuffers();
+    }
+
+    // Sizes every buffer for the ROI once, later frames only overwrite them
+    void allocateBuffers() {
+        roiBuffer.create(MAX_ROI_SIZE, CV_8UC3);
+        bits.create(MAX_ROI_SIZE.width, MAX_ROI_SIZE.height); // Capacity for the largest ROI
+        extractor.reserve(MAX_ROI_SIZE.width, MAX_ROI_SIZE.height);
+        hullIndices.reserve(1024);
+        defects.reserve(1024);
+    }
+
+    // Points the pipeline at a new frame, stages then run in GestureStage order
+    void begin(const Mat& input) { frame = input; }
+
+    // Runs every stage on frame, returns the finger count
+    int process(const Mat& input) {
+        uint64_t allocationsBefore = allocationCount();
+        begin(input);
+        for (int stage = 0; stage < STAGE_COUNT; stage++) runStage((GestureStage)stage);
+        frameAllocations = allocationCount() - allocationsBefore;
+        return detectedFingers;
+    }
+
+    void runStage(GestureStage stage) {
+        switch (stage) {
+        case STAGE_ROI: extractRoi(); break;
+        case STAGE_FLIP: mirror(); break;
+        case STAGE_SEGMENT: segment(); break;
+        case STAGE_MORPHOLOGY: cleanMask(); break;
+        case STAGE_SMOOTH: smoothMask(); break;
+        case STAGE_EXTRACT: extractHand(); break;
+        case STAGE_HULL: computeHull(); break;
+        case STAGE_DEFECTS: computeDefects(); break;
+        case STAGE_CLASSIFY: classify(); break;
+        default: break;
+        }
+    }
+
+    // A window inside a frame of this size, at most MAX_ROI_SIZE (the frame's corner when they do not overlap)
+    cv::Rect clampToFrame(cv::Rect rect, cv::Size size) const {
+        rect &= cv::Rect(0, 0, size.width, size.height);
+        rect.width = min(rect.width, MAX_ROI_SIZE.width);
+        rect.height = min(rect.height, MAX_ROI_SIZE.height);
+        if (rect.empty()) rect = cv::Rect(0, 0, min(size.width, MAX_ROI_SIZE.width), min(size.height, MAX_ROI_SIZE.height));
+        return rect;
+    }
+
+    // searchRect clamped to a frame the way extractRoi clamps it, for tools that cut the fixed window out themselves
+    cv::Rect searchRectIn(const Mat& image) const { return clampToFrame(searchRect, image.size()); }
+
+    // Picks this frame's ROI from the last frame's result and clamps it to the frame
+    void extractRoi() {
+        roiRect = clampToFrame(tracking ? (handFound ? followHand() : growToSearch()) : searchRect, frame.size());
+        // Mirroring maps column x to cols-1-x, so the mirrored rect starts at cols - (x + width)
+        sourceRect = cv::Rect(frame.cols - roiRect.x - roiRect.width, roiRect.y, roiRect.width, roiRect.height);
+    }
+
+    // Flip for mirror effect, only the ROI pixels are touched. When scaled, the ROI is
+    // box-filtered down first so the flip only sees the small image
+    void mirror() {
+        roi = roiBuffer(cv::Rect(0, 0, max(1, roiRect.width / scale), max(1, roiRect.height / scale)));
+        if (scale == 1) flip(frame(sourceRect), roi, 1);
+        else {
+            resize(frame(sourceRect), roi, roi.size(), 0, 0, INTER_AREA);
+            flip(roi, roi, 1);
+        }
+    }
+
+    // 1, 2 or 4, anything else is rounded down to the nearest of those
+    void setScale(int divisor) { scale = divisor >= 4 ? 4 : divisor >= 2 ? 2 : 1; }
+
+    // Thresholds at the processing scale; radii round to the nearest whole pixel but never drop to 0
+    int cleanupRadius() const { return max(1, (CLEANUP_RADIUS + scale / 2) / scale); }
+    double minHandArea() const { return MIN_HAND_AREA / (scale * scale); }
+    int minDefectDepth() const { return MIN_DEFECT_DEPTH * 256 / scale; } // 8.8 fixed point like the defect depth
+
+    // Hand's bounding box plus a margin, capped so a forearm leaving the bottom of the
+    // box cannot drag it down: the fingers are at the top, so the top edge is kept
+    cv::Rect followHand() const {
+        const cv::Rect& hand = handRect;
+        int margin = max(TRACK_MARGIN, max(hand.width, hand.height) / 4);
+        cv::Rect next(hand.x - margin, hand.y - margin, hand.width + 2 * margin, hand.height + 2 * margin);
+        if (next.width > MAX_ROI_SIZE.width) {
+            next.x += (next.width - MAX_ROI_SIZE.width) / 2;
+            next.width = MAX_ROI_SIZE.width;
+        }
+        next.height = min(next.height, MAX_ROI_SIZE.height);
+        return next;
+    }
+
+    // Hand lost: widen around where it was last seen, then fall back to the search window
+    cv::Rect growToSearch() const {
+        if (roiRect.area() >= searchRect.area()) return searchRect;
+        cv::Rect grown(roiRect.x - roiRect.width / 2, roiRect.y - roiRect.height / 2, roiRect.width * 2, roiRect.height * 2);
+        return grown.area() >= searchRect.area() ? searchRect : grown;
+    }
+
+    // 1-2. Skin color threshold straight from BGR, 1 bit per pixel: the calibrated color table when
+    // there is one, otherwise the fixed rule (same result as HSV (0,20,70)..(20,255,255))
+    void segment() {
+        if (skinTable && skinTable->ready) segmentSkinTable(roi, bits, *skinTable);
+        else segmentSkinPacked(roi, bits);
+    }
+
+    // 3. Clean up noise (Erosion/Dilation), 3x3 twice is the same as 5x5 once
+    void cleanMask() {
+        morphology.erode(bits, cleanupRadius());
+        morphology.dilate(bits, cleanupRadius());
+    }
+
+    // The old 5x5 Gaussian blur was only ever read as "non-zero" by findContours,
+    // and a blurred pixel is non-zero exactly when a set pixel lies within 2 pixels: a 5x5 dilation
+    void smoothMask() { morphology.dilate(bits, cleanupRadius()); }
+
+    // 4. Largest blob (assumed to be the hand) and its outer contour, only if the hand is big enough
+    // The contour stays in processing coordinates (the classifier only compares ratios),
+    // area and bounding box are reported back at full resolution
+    void extractHand() {
+        handFound = extractor.extract(bits, minHandArea());
+        maxArea = extractor.area * scale * scale;
+        const cv::Rect& b = extractor.bounds;
+        handRect = cv::Rect(roiRect.x + b.x * scale, roiRect.y + b.y * scale, b.width * scale, b.height * scale);
+    }
+
+    // Convex Hull
+    void computeHull() {
+        hullIndices.clear();
+        if (handFound) convexHull(extractor.contour, hullIndices, false);
+    }
+
+    // Convexity Defects (The gaps between fingers)
+    void computeDefects() {
+        defects.clear();
+        if (handFound && hullIndices.size() > 3) {
+            try { convexityDefects(extractor.contour, hullIndices, defects); }
+            catch (const cv::Exception&) { defects.clear(); } // Self-touching border (1 pixel wide neck), skip this frame
+        }
+    }
+
+    static long long squaredDistance(const Point& p, const Point& q) {
+        long long dx = p.x - q.x, dy = p.y - q.y;
+        return dx * dx + dy * dy;
+    }
+
+    void classify() {
+        if (!handFound) {
+            detectedFingers = 0; // Hand not found
+            return;
+        }
+        int count = 0;
+        for (const auto& v : defects) {
+            if (v[3] <= minDefectDepth()) continue; // Filter shallow defects (noise), depth is 8.8 fixed point
+
+            const Point& pStart = extractor.contour[v[0]];
+            const Point& pEnd = extractor.contour[v[1]];
+            const Point& pFar = extractor.contour[v[2]];
+
+            // Cosine Law: the angle at pFar is <= 90 degrees exactly when b^2 + c^2 - a^2 >= 0,
+            // so squared integer distances answer it without sqrt or acos (fingers are usually sharp angles)
+            long long a2 = squaredDistance(pEnd, pStart);
+            long long b2 = squaredDistance(pFar, pStart);
+            long long c2 = squaredDistance(pFar, pEnd);
+            if (b2 > 0 && c2 > 0 && b2 + c2 - a2 >= 0) {
+                count++;
+            }
+        }
+        // Logic: 0 defects = 1 finger (pointing) or fist.
+        // Let's assume 1 finger minimum if area is large.
+        // Formula: Fingers = Gaps + 1
+        detectedFingers = count + 1;
+
+        // Cap at 5
+        if (detectedFingers > 5) detectedFingers = 5;
+    }
+};
+
+class GestureTracker {
+public:
+    static constexpr float REQUIRED_HOLD_TIME = 0.2f; // Must hold gesture for 1 second to trigger
+    LatencyReport latency; // Recorded from both threads, print() any time
+
+    GestureTracker() {
+        //Initially Closed
+        pipeline.tracking = true;
+        voteFilter.window = REQUIRED_HOLD_TIME;
+    }
+
+    ~GestureTracker() {
+        stopCamera();
+    }
+
+    // Replaces where frames come from (default is the webcam), takes effect the next time it is enabled
+    void setSource(unique_ptr<FrameSource> newSource) {
+        stopCamera();
+        source = move(newSource);
+    }
+
+    // Starts/stops the camera thread, the render thread never opens or reads the camera itself
+    void setEnabled(bool enabled) {
+        if (enabled) {
+            if (!worker.joinable()) {
+                running = true;
+                worker = thread(&GestureTracker::workerLoop, this);
+            }
+        }
+        else {
+            stopCamera();
+        }
+    }
+
+    void stopCamera() {
+        running = false;
+        if (worker.joinable()) worker.join(); // Worker closes the source on exit
+    }
+
+    // Tracking ROI (default) or the fixed box, set before enabling
+    void setTracking(bool enabled) { pipeline.tracking = enabled; }
+
+    // Processing scale divisor 1, 2 or 4 (less precision, less CPU), set before enabling
+    void setScale(int divisor) { pipeline.setScale(divisor); }
+
+    // Detection passes per second of camera time, 0 = every new camera frame; set before enabling
+    void setDetectionRate(double hz) {
+        scheduler.rateHz = max(0.0, hz);
+        voteFilter.window = min(voteFilter.window, FingerVoteFilter::maxWindow(scheduler.rateHz));
+    }
+
+    // Vote window (seconds) and the share of frames that must agree in it, set before enabling.
+    // The window is capped to what the vote ring holds at the detection rate
+    void setVoteFilter(double windowSeconds, double threshold) {
+        voteFilter.window = std::clamp(windowSeconds, 0.0, FingerVoteFilter::maxWindow(scheduler.rateHz));
+        voteFilter.threshold = std::clamp(threshold, 0.0, 1.0);
+    }
+
+    // Embedded thumbnail or no preview at all, set before enabling
+    void setPreviewMode(PreviewMode mode) { previewMode = mode; }
+
+    // Only detect while the quiz is on screen, called once per render frame and never blocks
+    void setActive(bool active) {
+        isActive.store(active, memory_order_relaxed);
+    }
+
+    // Returns true ONE time when the gesture is locked, then resets
+    bool consumeTrigger(int& outFingerCount) {
+        const GestureState& state = results.acquire();
+        if (state.lockSequence != consumedSequence) {
+            consumedSequence = state.lockSequence;
+            outFingerCount = state.lockedCount; // The count that locked, the newest frame may already show another
+            consumedAt = chrono::steady_clock::now();
+            consumedLockCaptureTime = state.lockCaptureTime;
+            latency.record(HOP_LOCK_TO_CONSUME, state.lockTime, consumedAt);
+            return true;
+        }
+        return false;
+    }
+
+    // Called right after window.display() of the first frame that shows what the last trigger did
+    void recordFeedbackShown() {
+        auto now = chrono::steady_clock::now();
+        latency.record(HOP_CONSUME_TO_FEEDBACK, consumedAt, now);
+        latency.record(HOP_CAPTURE_TO_FEEDBACK, consumedLockCaptureTime, now);
+    }
+
+    // Newest detection result, for on-screen feedback (render thread)
+    const GestureState& latestState() { return results.acquire(); }
+
+    // Next second of camera frames calibrates the skin color table, the hand should fill the box (render thread)
+    void requestCalibration() { calibrateRequested.store(true, memory_order_relaxed); }
+
+    // Where the calibrated skin table is loaded from and saved to, set before enabling
+    void setSkinTablePath(const string& path) { skinTablePath = path; }
+
+    // Uploads the newest preview image into texture (PREVIEW_SIZE square, created by the caller),
+    // in place and only when a new one arrived. Returns false while there is nothing to show (render thread)
+    bool updatePreview(Texture& texture) {
+        if (previewMode == PreviewMode::None) return false;
+        const GesturePreview& latest = previews.acquire();
+        if (latest.sequence == 0) return false;
+        if (latest.sequence != shownPreviewSequence) {
+            texture.update(latest.rgba.data());
+            shownPreviewSequence = latest.sequence;
+        }
+        return true;
+    }
+
+private:
+    // Camera thread state, the render thread sees it only through the results slot and changes it only through
+    // the setters above (called while the camera thread is stopped)
+    int detectedFingers = 0;
+    // Logic for "Holding" a gesture
+    int lastStableCount = 0; // Count currently winning the vote
+    float holdTime = 0.0f;
+    FingerVoteFilter voteFilter; // window defaults to REQUIRED_HOLD_TIME
+    GestureScheduler scheduler;
+    PreviewMode previewMode = PreviewMode::Embedded;
+
+    thread worker;
+    atomic<bool> running{ false };
+    atomic<bool> isActive{ false };
+    LatestValueSlot<GestureState> results; // Camera thread -> render thread
+    LatestValueSlot<GesturePreview> previews; // Camera thread -> render thread
+    GesturePreview stagedPreview; // Camera thread copy, written in place by cvtColor
+    uint64_t shownPreviewSequence = 0; // Render thread copy
+    chrono::steady_clock::time_point consumedAt, consumedLockCaptureTime; // Render thread, last consumed trigger
+    uint64_t lockSequence = 0; // Camera thread copy
+    uint64_t consumedSequence = 0; // Render thread copy
+    unique_ptr<FrameSource> source;
+    TimedFrame timed;
+    Mat frame;
+    Mat previewBgr; // ROI scaled to PREVIEW_SIZE, reused
+    GesturePipeline pipeline;
+    chrono::steady_clock::time_point lockCaptureTime, lockTime; // Last lock (camera thread)
+    int lockedCount = 0;
+
+    // Skin color calibration (camera thread only, except the request flag)
+    static constexpr double CALIBRATION_SECONDS = 1.0; // Asked for by the user
+    static constexpr double RECALIBRATION_SECONDS = 0.5; // Started by a lighting change
+    static constexpr double LUMA_DRIFT = 25.0; // Mean ROI brightness change that counts as new lighting
+    static constexpr int LUMA_CHECK_FRAMES = 15;
+    SkinColorTable skinTable;
+    string skinTablePath = "skin_table.bin";
+    atomic<bool> calibrateRequested{ false };
+    double calibrationEnd = -1; // Camera timestamp the running calibration ends at, -1 = none running
+    double calibratedLuma = -1; // ROI brightness the table was last calibrated under, -1 = not measured yet
+    int framesSinceLumaCheck = 0;
+    BitMask sampleSkin, sampleSkinMargin, sampleBackground, sampleRule; // Calibration masks, reused
+    bool automaticCalibration = false; // Started by a lighting change rather than by the user
+    int calibrationSamples = 0; // Frames added by the running calibration
+    BinaryMorphology sampleMorphology;
+
+    // Runs on the camera thread until stopCamera()
+    void workerLoop() {
+        if (!skinTable.ready && skinTable.load(skinTablePath)) pipeline.skinTable = &skinTable;
+        if (!source) source = make_unique<CameraSource>();
+        source->loop = true; // Recordings repeat while the game runs
+        source->preferredSize = cv::Size(pipeline.searchRect.br()); // Frame must contain the search window
+        if (!source->open()) {
+            cerr << "Warning: Could not open " << source->describe() << ", gesture control disabled." << endl;
+            return;
+        }
+
+        while (running.load()) {
+            if (!isActive.load(memory_order_relaxed)) {
+                lastStableCount = 0;
+                holdTime = 0;
+                voteFilter.reset();
+                scheduler.reset();
+                this_thread::sleep_for(chrono::milliseconds(20));
+                continue;
+            }
+            if (!source->read(timed)) { // Blocks on the device, but only this thread waits
+                this_thread::sleep_for(chrono::milliseconds(5));
+                continue;
+            }
+            // Frames are always read so the driver queue stays fresh, but only due ones are processed
+            if (!scheduler.due(timed.timestamp)) continue;
+            frame = timed.image;
+            update(timed.timestamp, timed.captureTime);
+        }
+        source->close();
+    }
+
+    // timestamp is the frame's capture time in seconds: hold time is measured on the camera clock,
+    // so lock latency does not depend on how often detection or rendering runs
+    void update(double timestamp, chrono::steady_clock::time_point captureTime) {
+        detectedFingers = pipeline.process(frame);
+        auto detectedAt = chrono::steady_clock::now();
+        latency.record(HOP_CAPTURE_TO_DETECT, captureTime, detectedAt);
+
+        // 5. Stability Logic (Must hold gesture to trigger), a majority vote over the last window of frames
+        if (voteFilter.update(timestamp, detectedFingers)) {
+            lockSequence++; // Render thread picks this up in consumeTrigger()
+            lockedCount = voteFilter.lockedCount();
+            lockCaptureTime = captureTime;
+            lockTime = detectedAt;
+            auto windowStartCapture = captureTime - chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(timestamp - voteFilter.lockedWindowStart()));
+            latency.record(HOP_HOLD_TO_LOCK, windowStartCapture, lockTime);
+            lastStableCount = lockedCount;
+            holdTime = 0;
+        }
+        else {
+            lastStableCount = voteFilter.leadingCount();
+            holdTime = lastStableCount > 0 ? (float)voteFilter.heldFor(timestamp) : 0.0f;
+        }
+
+        // Skin table: on request, or by itself when the lighting drifted while a hand is visible
+        if (calibrateRequested.exchange(false, memory_order_relaxed)) startCalibration(timestamp, CALIBRATION_SECONDS, false);
+        else if (calibrationEnd < 0 && skinTable.ready && lightingChanged()) startCalibration(timestamp, RECALIBRATION_SECONDS, true);
+        if (calibrationEnd >= 0) collectSkinSamples(timestamp);
+
+        GestureState state;
+        state.detectedFingers = detectedFingers;
+        state.stableCount = lastStableCount;
+        state.calibrating = calibrationEnd >= 0;
+        state.holdProgress = voteFilter.window > 0 ? min(1.0f, holdTime / (float)voteFilter.window) : 1.0f;
+        state.lockSequence = lockSequence;
+        state.lockedCount = lockedCount;
+        state.captureTime = captureTime;
+        state.lockCaptureTime = lockCaptureTime;
+        state.lockTime = lockTime;
+        results.publish(state);
+
+        // Hold/lock feedback is drawn by the game from GestureState, only the pixels travel here
+        if (previewMode == PreviewMode::Embedded) publishPreview();
+    }
+
+    void startCalibration(double timestamp, double seconds, bool automatic) {
+        calibrationEnd = timestamp + seconds;
+        automaticCalibration = automatic;
+        calibrationSamples = 0;
+    }
+
+    // Old statistics are halved (once per calibration, and only when it has samples) rather than dropped,
+    // the new samples then outweigh them
+    void addCalibrationSamples(const Mat& roi) {
+        if (calibrationSamples++ == 0) skinTable.decay();
+        skinTable.addSamples(roi, sampleSkin, sampleBackground);
+    }
+
+    // Whole camera frame, so a hand moving over a different background does not read as new lighting
+    double frameLuma() const {
+        Scalar m = mean(frame);
+        return 0.114 * m[0] + 0.587 * m[1] + 0.299 * m[2];
+    }
+
+    // Checked every LUMA_CHECK_FRAMES frames and only while a hand is found, so the new samples are the hand
+    bool lightingChanged() {
+        if (++framesSinceLumaCheck < LUMA_CHECK_FRAMES || !pipeline.handFound) return false;
+        framesSinceLumaCheck = 0;
+        double luma = frameLuma();
+        if (calibratedLuma < 0) calibratedLuma = luma; // First check after loading a saved table
+        return abs(luma - calibratedLuma) > LUMA_DRIFT;
+    }
+
+    // Adds this frame's ROI to the table statistics, rebuilds and saves the table once the time is up
+    void collectSkinSamples(double timestamp) {
+        const Mat& roi = pipeline.roi;
+        if (automaticCalibration) {
+            // Started by itself: only frames with a confirmed hand, labelled by the fixed HSV rule rather than by
+            // the table being retrained, so the table's own mistakes are never fed back into it
+            if (pipeline.handFound) {
+                segmentSkinPacked(roi, sampleRule);
+                labelSamples(sampleRule);
+                addCalibrationSamples(roi);
+            }
+        }
+        else if (pipeline.handFound) {
+            labelSamples(pipeline.bits);
+            addCalibrationSamples(roi);
+        }
+        else {
+            // Nothing detected (the fixed rule may fail under this light): the user fills the box,
+            // its middle third is taken as skin and its outer tenth as background
+            sampleSkin.create(roi.cols, roi.rows);
+            sampleBackground.create(roi.cols, roi.rows);
+            cv::Rect middle(roi.cols / 3, roi.rows / 3, roi.cols / 3, roi.rows / 3);
+            cv::Rect inner(roi.cols / 10, roi.rows / 10, roi.cols - 2 * (roi.cols / 10), roi.rows - 2 * (roi.rows / 10));
+            for (int y = 0; y < roi.rows; y++) {
+                uint64_t* skinRow = sampleSkin.row(y);
+                uint64_t* backgroundRow = sampleBackground.row(y);
+                fill(skinRow, skinRow + sampleSkin.wordsPerRow, 0ULL);
+                fill(backgroundRow, backgroundRow + sampleBackground.wordsPerRow, 0ULL);
+                for (int x = 0; x < roi.cols; x++) {
+                    if (middle.contains(Point(x, y))) skinRow[x / 64] |= 1ULL << (x % 64);
+                    else if (!inner.contains(Point(x, y))) backgroundRow[x / 64] |= 1ULL << (x % 64);
+                }
+            }
+            addCalibrationSamples(roi);
+        }
+
+        if (timestamp < calibrationEnd) return;
+        calibrationEnd = -1;
+        framesSinceLumaCheck = 0;
+        if (calibrationSamples == 0) return; // Hand never confirmed, the table is untouched and the next check retries
+        skinTable.rebuild();
+        pipeline.skinTable = &skinTable;
+        calibratedLuma = frameLuma();
+        if (!skinTable.save(skinTablePath)) cerr << "Warning: Could not save the skin color table to " << skinTablePath << "." << endl;
+    }
+
+    // Well inside the skin mask is skin, well away from it is background
+    void labelSamples(const BitMask& skin) {
+        sampleSkin = skin;
+        sampleMorphology.erode(sampleSkin, 3);
+        sampleSkinMargin = skin;
+        sampleMorphology.dilate(sampleSkinMargin, 6);
+        invertMask(sampleSkinMargin, sampleBackground);
+    }
+
+    // Scales the ROI the pipeline already mirrored to the preview size and converts it straight
+    // into the staged RGBA buffer (cvtColor writes in place since size and type never change)
+    void publishPreview() {
+        stagedPreview.rgba.resize((size_t)PREVIEW_SIZE * PREVIEW_SIZE * 4);
+        Mat rgba(PREVIEW_SIZE, PREVIEW_SIZE, CV_8UC4, stagedPreview.rgba.data());
+        resize(pipeline.roi, previewBgr, cv::Size(PREVIEW_SIZE, PREVIEW_SIZE), 0, 0, INTER_NEAREST);
+        cvtColor(previewBgr, rgba, COLOR_BGR2RGBA);
+        stagedPreview.sequence++;
+        previews.publish(stagedPreview);
+    }
+};
+
+
+
+
+// --------------------------------------------------------
+//            FRAME PROFILER
+// --------------------------------------------------------
+
+// Phases of one main loop iteration, in the order they run
+enum FramePhase {
+    PHASE_INPUT, // Gesture result pickup, background pulse, event polling
+    PHASE_GESTURE, // Acting on a gesture trigger
+    PHASE_HOVER, // Hover effects
+    PHASE_SIMULATION, // Particles and floating text
+    PHASE_TIMERS, // Quiz timer, screen shake, fade
+    PHASE_DRAW, // clear() through the per-state draw chain
+    PHASE_OVERLAY, // This profiler's own overlay
+    PHASE_DISPLAY, // display(), includes the frame rate limiter sleep
+    PHASE_COUNT
+};
+
+const char* const FRAME_PHASE_NAMES[PHASE_COUNT] = {
+    "input", "gesture", "hover", "simulation", "timers", "draw", "overlay", "display"
+};
+
+const Color FRAME_PHASE_COLORS[PHASE_COUNT] = {
+    Color(80, 160, 255), Color(255, 140, 0), Color(160, 100, 255), Color(0, 200, 120),
+    Color(255, 220, 0), Color(230, 60, 60), Color(130, 130, 130), Color(60, 60, 60)
+};
+
+const char* const GAME_STATE_NAMES[] = {
+    "MENU", "SELECT_DIFFICULTY", "SET_LIMIT", "SETTINGS", "QUIZ_MODE", "PAUSED", "GAME_OVER"
+};
+
+// Per-phase frame times of the last HISTORY frames in a ring buffer. The loop calls lap(phase)
+// at the end of each phase: phases run back to back, so each lap is a scoped timer that
+// starts where the previous one stopped and every millisecond of the frame lands in exactly one phase
+class FrameProfiler {
+public:
+    static constexpr int HISTORY = 3600; // One minute at 60 fps, all of it goes to the CSV
+    static constexpr int OVERLAY_FRAMES = 240; // Bars shown by the overlay
+    bool overlayVisible = false;
+
+    explicit FrameProfiler(const Font& font) : legend(font, "", 14) {
+        legend.setFillColor(Color::White);
+        legend.setOutlineColor(Color::Black);
+        legend.setOutlineThickness(1);
+        bars.setPrimitiveType(PrimitiveType::Triangles);
+    }
+
+    void beginFrame(GameState state) {
+        Sample& s = samples[next];
+        s = Sample();
+        s.state = (uint8_t)state;
+        lapStart = chrono::steady_clock::now();
+    }
+
+    // Closes the running phase
+    void lap(FramePhase phase) {
+        auto now = chrono::steady_clock::now();
+        samples[next].ms[phase] += chrono::duration<float, milli>(now - lapStart).count();
+        lapStart = now;
+    }
+
+    void endFrame() {
+        next = (next + 1) % HISTORY;
+        if (recorded < HISTORY) recorded++;
+        frameNumber++;
+    }
+
+    // Stacked bar per frame (newest on the right) with a 60 fps budget line and a per-phase legend
+    void drawOverlay(RenderTarget& target) {
+        const float originX = WINDOW_WIDTH - OVERLAY_FRAMES * BAR_WIDTH - 20.f;
+        const float baseY = WINDOW_HEIGHT - 20.f;
+        bars.clear();
+        addQuad(originX - 4.f, baseY - MAX_MS * PX_PER_MS - 4.f, OVERLAY_FRAMES * BAR_WIDTH + 8.f, MAX_MS * PX_PER_MS + 8.f, Color(0, 0, 0, 160));
+        int shown = min(recorded, OVERLAY_FRAMES);
+        float sums[PHASE_COUNT] = {};
+        for (int i = 0; i < shown; i++) {
+            const Sample& s = samples[(next - shown + i + HISTORY) % HISTORY];
+            float x = originX + (OVERLAY_FRAMES - shown + i) * BAR_WIDTH;
+            float y = baseY;
+            for (int phase = 0; phase < PHASE_COUNT; phase++) {
+                float h = min(s.ms[phase] * PX_PER_MS, y - (baseY - MAX_MS * PX_PER_MS)); // Clip at the top
+                addQuad(x, y - h, BAR_WIDTH, h, FRAME_PHASE_COLORS[phase]);
+                y -= h;
+                sums[phase] += s.ms[phase];
+            }
+        }
+        addQuad(originX, baseY - 16.67f * PX_PER_MS, OVERLAY_FRAMES * BAR_WIDTH, 1.f, Color::White); // 60 fps budget
+        const float legendX = originX - 190.f, legendY = baseY - MAX_MS * PX_PER_MS;
+        for (int phase = 0; phase < PHASE_COUNT; phase++) { // Color keys next to the legend lines
+            addQuad(legendX - 15.f, legendY + 4.f + (phase + 1) * legendLineHeight(), 10.f, 10.f, FRAME_PHASE_COLORS[phase]);
+        }
+        target.draw(bars);
+
+        ostringstream text;
+        text << fixed << setprecision(2) << "avg ms over " << shown << " frames (" << GAME_STATE_NAMES[samples[(next + HISTORY - 1) % HISTORY].state] << ")\n";
+        for (int phase = 0; phase < PHASE_COUNT; phase++) text << FRAME_PHASE_NAMES[phase] << ": " << (shown ? sums[phase] / shown : 0.f) << "\n";
+        legend.setString(text.str());
+        legend.setPosition({ legendX, legendY });
+        target.draw(legend);
+    }
+
+    // Writes every recorded frame, oldest first; returns false if the file can't be written
+    bool writeCsv(const string& path) const {
+        ofstream out(path);
+        if (!out.is_open()) return false;
+        out << "frame,state";
+        for (int phase = 0; phase < PHASE_COUNT; phase++) out << "," << FRAME_PHASE_NAMES[phase] << "_ms";
+        out << ",total_ms\n";
+        out << fixed << setprecision(3);
+        for (int i = 0; i < recorded; i++) {
+            const Sample& s = samples[(next - recorded + i + HISTORY) % HISTORY];
+            float total = 0;
+            out << frameNumber - recorded + i << "," << GAME_STATE_NAMES[s.state];
+            for (int phase = 0; phase < PHASE_COUNT; phase++) {
+                out << "," << s.ms[phase];
+                total += s.ms[phase];
+            }
+            out << "," << total << "\n";
+        }
+        return true;
+    }
+
+    // Per-state summary of the recorded frames for comparing runs (e.g. with and without --no-layer-cache).
+    // "work" is the frame minus display(), whose frame rate limiter sleep would hide any saving
+    void printSummary(ostream& out) const {
+        vector<float> draw[size(GAME_STATE_NAMES)], work[size(GAME_STATE_NAMES)];
+        for (int i = 0; i < recorded; i++) {
+            const Sample& s = samples[(next - recorded + i + HISTORY) % HISTORY];
+            float total = 0;
+            for (int phase = 0; phase < PHASE_DISPLAY; phase++) total += s.ms[phase];
+            draw[s.state].push_back(s.ms[PHASE_DRAW]);
+            work[s.state].push_back(total);
+        }
+        out << fixed << setprecision(3);
+        for (size_t state = 0; state < size(GAME_STATE_NAMES); state++) {
+            if (work[state].empty()) continue;
+            vector<float>& w = work[state];
+            sort(w.begin(), w.end());
+            out << "Frame time " << GAME_STATE_NAMES[state] << ": " << w.size() << " frames, draw mean "
+                << accumulate(draw[state].begin(), draw[state].end(), 0.0) / w.size() << " ms, work mean "
+                << accumulate(w.begin(), w.end(), 0.0) / w.size() << " ms, p99 " << w[min(w.size() - 1, w.size() * 99 / 100)] << " ms" << endl;
+        }
+        out << defaultfloat;
+    }
+
+private:
+    struct Sample {
+        float ms[PHASE_COUNT] = {};
+        uint8_t state = 0;
+    };
+    static constexpr float BAR_WIDTH = 2.f;
+    static constexpr float PX_PER_MS = 6.f;
+    static constexpr float MAX_MS = 40.f; // Bars are clipped here
+
+    vector<Sample> samples = vector<Sample>(HISTORY); // Allocated once
+    int next = 0;
+    int recorded = 0;
+    uint64_t frameNumber = 0;
+    chrono::steady_clock::time_point lapStart;
+    VertexArray bars; // Two triangles per phase per frame, rebuilt in place
+    Text legend;
+
+    float legendLineHeight() const { return legend.getFont().getLineSpacing(legend.getCharacterSize()); }
+
+    void addQuad(float x, float y, float w, float h, Color color) {
+        if (h <= 0) return;
+        Vertex a{ { x, y }, color, {} }, b{ { x + w, y }, color, {} }, c{ { x + w, y + h }, color, {} }, d{ { x, y + h }, color, {} };
+        bars.append(a); bars.append(b); bars.append(c);
+        bars.append(a); bars.append(c); bars.append(d);
+    }
+};
+
+
+// Drops the render loop to a slow tick while nothing on screen moves. The frame loop reports input and
+// animation, and once both have been quiet for WAKE_GRACE it blocks in waitEvent() instead of spinning at 60 fps
+class FrameGovernor {
+public:
+    static constexpr float IDLE_FPS = 10.f; // Enough for the background pulse and the text cursor
+    static constexpr float WAKE_GRACE = 0.5f; // Seconds at full rate after the last input or animation
+    bool enabled = true;
+
+    // Start of a frame: waits up to one idle tick for an event when idle, returns it so the poll loop handles it
+    optional<Event> wait(RenderWindow& window) {
+        if (!enabled || quietFor < WAKE_GRACE) return nullopt;
+        float remaining = 1.f / IDLE_FPS - sinceFrame.getElapsedTime().asSeconds(); // Part of the tick the last frame already used
+        if (remaining <= 0) return nullopt;
+        return window.waitEvent(seconds(remaining));
+    }
+
+    // End of a frame: anything that moved or any input keeps the loop at full rate
+    void endFrame(float dt, bool busy) {
+        if (busy) quietFor = 0;
+        else quietFor += dt;
+        double cpu = processCpuSeconds();
+        if (quietFor < WAKE_GRACE) busyFrames++;
+        else { // Quiet periods are classified the same with the governor off, so both runs measure the same thing
+            idleFrames++;
+            idleWallSeconds += sinceFrame.getElapsedTime().asSeconds();
+            idleCpuSeconds += cpu - lastCpuSeconds;
+        }
+        lastCpuSeconds = cpu;
+        sinceFrame.restart();
+    }
+
+    void print(ostream& out) const {
+        out << "Frames: " << busyFrames << " at full rate, " << idleFrames << " idle" << (enabled ? "" : " (governor off)") << endl;
+        if (idleWallSeconds > 0) {
+            out << "Idle CPU: " << fixed << setprecision(1) << 100.0 * idleCpuSeconds / idleWallSeconds << "% of one core over "
+                << idleWallSeconds << " s (all threads, camera included)" << defaultfloat << endl;
+        }
+    }
+
+private:
+    float quietFor = 0;
+    Clock sinceFrame;
+    uint64_t busyFrames = 0, idleFrames = 0;
+    double lastCpuSeconds = processCpuSeconds();
+    double idleCpuSeconds = 0, idleWallSeconds = 0;
+
+    // User + system time of the whole process
+    static double processCpuSeconds() {
+#ifdef _WIN32
+        FILETIME created, exited, kernel, user;
+        if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0;
+        auto ticks = [](const FILETIME& t) { return ((uint64_t)t.dwHighDateTime << 32) | t.dwLowDateTime; };
+        return (ticks(kernel) + ticks(user)) * 1e-7; // 100 ns units
+#else
+        return (double)clock() / CLOCKS_PER_SEC;
+#endif
+    }
+};
+
+// --------------------------------------------------------
+//            QUESTION BANKS (Compiled, Memory-Mapped)
+// --------------------------------------------------------
+
+// A whole file mapped read-only, the OS pages it in on first touch
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const string& path) {
+        close();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize{};
+        if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+            if (HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)) {
+                bytes = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                CloseHandle(mapping); // The view keeps the mapping alive
+            }
+            if (bytes) length = (size_t)fileSize.QuadPart;
+        }
+        CloseHandle(file);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info {};
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* p = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                bytes = static_cast<const char*>(p);
+                length = (size_t)info.st_size;
+            }
+        }
+        ::close(fd); // The mapping stays valid without the descriptor
+#endif
+        return bytes != nullptr;
+    }
+
+    void close() {
+        if (!bytes) return;
+#ifdef _WIN32
+        UnmapViewOfFile(bytes);
+#else
+        munmap(const_cast<char*>(bytes), length);
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+};
+
+// Compiled bank layout (little endian): header, fixed-size record table, then one string blob.
+// Every string is an (offset, length) pair into the blob, so reading a question is pointer arithmetic
+struct BankHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t questionCount;
+    uint32_t recordSize; // sizeof(BankRecord) of the writer, checked on open
+    uint64_t recordsOffset;
+    uint64_t blobOffset;
+    uint64_t blobSize;
+};
+
+struct BankRecord {
+    uint32_t textOffset, textLength;
+    uint32_t optionOffset[4], optionLength[4];
+    uint32_t correctAnswerIndex;
+};
+static_assert(sizeof(BankHeader) == 40 && sizeof(BankRecord) == 44, "The bank layout is part of the file format");
+
+// A malformed line in a text bank
+struct BankParseError {
+    size_t line = 0; // 1-based
+    string message;
+};
+
+// Text bank parser. The whole file sits in one buffer that is scanned once: fields are split and "\n" escapes
+// unescaped in place, and every record points back into the buffer, which then serves as the bank's string blob.
+// Nothing is allocated per line, and big files are cut at line boundaries and parsed by several threads
+class QuestionTextParser {
+public:
+    static constexpr size_t MIN_CHUNK = 1 << 20; // Bytes per thread, smaller files are parsed on the calling thread
+
+    // threads = 0 uses every core. Records come out in file order, errors carry file line numbers
+    static void parse(char* data, size_t size, vector<BankRecord>& records, vector<BankParseError>& errors, unsigned threads = 0) {
+        records.clear();
+        errors.clear();
+        if (size > UINT32_MAX) { // Offsets are 32-bit like in the compiled format
+            errors.push_back({ 0, "file is larger than 4 GB" });
+            return;
+        }
+        if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+        size_t chunkCount = max<size_t>(1, min<size_t>(threads, size / MIN_CHUNK));
+        vector<Chunk> chunks(chunkCount);
+        size_t begin = 0;
+        for (size_t i = 0; i < chunkCount; i++) {
+            size_t end = size;
+            if (i + 1 < chunkCount) {
+                size_t target = max(begin, size / chunkCount * (i + 1));
+                const char* newline = static_cast<const char*>(memchr(data + target, '\n', size - target));
+                end = newline ? (size_t)(newline - data) + 1 : size;
+            }
+            chunks[i].begin = begin;
+            chunks[i].end = end;
+            begin = end;
+        }
+        if (chunkCount == 1) {
+            parseChunk(data, chunks[0]);
+        }
+        else {
+            vector<thread> workers;
+            for (Chunk& chunk : chunks) workers.emplace_back(parseChunk, data, ref(chunk));
+            for (thread& worker : workers) worker.join();
+        }
+        if (chunkCount == 1) {
+            records = move(chunks[0].records);
+            errors = move(chunks[0].errors);
+            return;
+        }
+        size_t total = 0;
+        for (const Chunk& chunk : chunks) total += chunk.records.size();
+        records.reserve(total);
+        size_t lineBase = 0;
+        for (Chunk& chunk : chunks) {
+            records.insert(records.end(), chunk.records.begin(), chunk.records.end());
+            for (BankParseError& error : chunk.errors) {
+                error.line += lineBase;
+                errors.push_back(move(error));
+            }
+            lineBase += chunk.lines;
+        }
+    }
+
+private:
+    static constexpr int FIELD_COUNT = 6; // Question|A|B|C|D|CorrectIndex
+
+    struct Chunk {
+        size_t begin = 0, end = 0;
+        size_t lines = 0; // Lines seen, for turning chunk line numbers into file line numbers
+        vector<BankRecord> records;
+        vector<BankParseError> errors;
+    };
 
-// Data Structure
-struct QuizQuestion {
-    string questionText;
-    vector<string> options; // Dynamic list to store 4 options
-    int correctAnswerIndex;
-    int userSelectedOption = -1; // Remembers what user clicked (-1 means nothing)
-};
+    static void parseChunk(char* data, Chunk& chunk) {
+        chunk.records.reserve((chunk.end - chunk.begin) / 64); // Rough guess, avoids most regrowth
+        size_t pos = chunk.begin;
+        while (pos < chunk.end) {
+            const char* newline = static_cast<const char*>(memchr(data + pos, '\n', chunk.end - pos));
+            size_t lineEnd = newline ? (size_t)(newline - data) : chunk.end;
+            chunk.lines++;
+            BankRecord record;
+            if (parseLine(data, pos, lineEnd, record, chunk)) chunk.records.push_back(record);
+            pos = lineEnd + 1;
+        }
+    }
 
-// Particles for wrong answers
-struct Particle {
-    RectangleShape shape;
-    Vector2f velocity; // Speed in x y directions of particles, vector2f holds two floating point numbers
-    float lifetime; // For Countdown
-};
+    // False for blank, comment and malformed lines (the latter also add an error)
+    static bool parseLine(char* data, size_t begin, size_t end, BankRecord& record, Chunk& chunk) {
+        if (end > begin && data[end - 1] == '\r') end--; // Windows line endings
+        if (begin == end || data[begin] == '#') return false;
+
+        uint32_t fieldBegin[FIELD_COUNT], fieldEnd[FIELD_COUNT];
+        int fields = 0;
+        size_t start = begin;
+        for (size_t i = begin; i <= end; i++) {
+            if (i < end && data[i] != '|') continue;
+            if (fields < FIELD_COUNT) {
+                fieldBegin[fields] = (uint32_t)start;
+                fieldEnd[fields] = (uint32_t)i;
+            }
+            fields++;
+            start = i + 1;
+        }
+        if (fields != FIELD_COUNT) {
+            chunk.errors.push_back({ chunk.lines, "expected " + to_string(FIELD_COUNT) + " fields separated by '|', found " + to_string(fields) });
+            return false;
+        }
 
-// Floating Text (+1) for correct answer
-struct FloatingText {
-    Text text;
-    float lifetime;
-    float speed;
-    FloatingText(const Font& font, const string& str, float x, float y) // Constructor
-        : text(font, str, 30)
-    {
-        text.setPosition({ x, y });
-        text.setFillColor(Color::Green);
-        text.setOutlineColor(Color::White);
-        text.setOutlineThickness(2);
-        lifetime = 1.0f;
-        speed = 100.0f;
+        // Answer index, surrounding spaces allowed
+        const char* first = data + fieldBegin[5];
+        const char* last = data + fieldEnd[5];
+        while (first < last && (*first == ' ' || *first == '\t')) first++;
+        while (last > first && (last[-1] == ' ' || last[-1] == '\t')) last--;
+        int answer = -1;
+        auto [parsedTo, ec] = from_chars(first, last, answer);
+        if (ec != errc() || parsedTo != last || answer < 0 || answer > 3) {
+            chunk.errors.push_back({ chunk.lines, "answer index '" + string(first, last) + "' is not 0-3" });
+            return false;
+        }
+
+        // Question text: turn the two characters \n into a newline, shifting the rest of the field left
+        uint32_t write = fieldBegin[0];
+        for (uint32_t read = fieldBegin[0]; read < fieldEnd[0]; read++) {
+            if (data[read] == '\\' && read + 1 < fieldEnd[0] && data[read + 1] == 'n') {
+                data[write++] = '\n';
+                read++;
+            }
+            else {
+                data[write++] = data[read];
+            }
+        }
+        record.textOffset = fieldBegin[0];
+        record.textLength = write - fieldBegin[0];
+        for (int k = 0; k < 4; k++) {
+            record.optionOffset[k] = fieldBegin[k + 1];
+            record.optionLength[k] = fieldEnd[k + 1] - fieldBegin[k + 1];
+        }
+        record.correctAnswerIndex = (uint32_t)answer;
+        return true;
     }
 };
 
-// --------------------------------------------------------
-//            NEW CLASS: HAND GESTURE TRACKER
-// --------------------------------------------------------
+// One question as views into its bank, valid as long as the bank stays open
+struct QuestionView {
+    string_view text;
+    array<string_view, 4> options;
+    int correctAnswerIndex = 0;
+};
 
+// Anything the game reads questions from by index
+class QuestionSource {
+public:
+    virtual ~QuestionSource() = default;
+    virtual size_t size() const = 0;
+    virtual QuestionView operator[](size_t index) const = 0;
+    bool empty() const { return size() == 0; }
+};
 
-class GestureTracker {
+// Read-only question storage. Compiled banks are mapped as they are (opening checks only the header, so it costs
+// the same for 300 or 300,000 questions). Text banks are parsed in place into the same record layout, so the game reads both the same way
+class QuestionBank : public QuestionSource {
 public:
-    VideoCapture cap;
-    int detectedFingers = 0;
-    // Logic for "Holding" a gesture
-    int lastStableCount = 0;
-    float holdTime = 0.0f;
-    const float REQUIRED_HOLD_TIME = 0.2f; // Must hold gesture for 1 second to trigger
-    bool triggerAction = false; // True when action should fire
-    bool isWindowOpen = false;
-    bool isActive = false;
+    static constexpr uint32_t FILE_MAGIC = 0x314B4251; // "QBK1"
+    static constexpr uint32_t VERSION = 1;
+
+    QuestionBank() = default;
+    QuestionBank(const QuestionBank&) = delete;
+    QuestionBank& operator=(const QuestionBank&) = delete;
+
+    bool openCompiled(const string& path) {
+        reset();
+        if (!mapped.open(path)) return false;
+        if (!attach(mapped.data(), mapped.size())) {
+            cerr << "Warning: " << path << " is not a version " << VERSION << " question bank, recompile it with --compile-bank." << endl;
+            reset();
+            return false;
+        }
+        return true;
+    }
 
-    GestureTracker() {
-        //Initially Closed
+    // The file buffer becomes the blob, malformed lines are reported with their line numbers and skipped
+    bool loadText(const string& path, unsigned threads = 0) {
+        reset();
+        ifstream file(path, ios::binary | ios::ate);
+        if (!file.is_open()) return false;
+        owned.resize((size_t)file.tellg());
+        file.seekg(0);
+        if (!file.read(owned.data(), (streamsize)owned.size())) {
+            reset();
+            return false;
+        }
+        vector<BankParseError> errors;
+        QuestionTextParser::parse(owned.data(), owned.size(), ownedRecords, errors, threads);
+        for (size_t i = 0; i < errors.size() && i < MAX_REPORTED_ERRORS; i++) {
+            cerr << "Warning: " << path << ":" << errors[i].line << ": " << errors[i].message << ", line skipped." << endl;
+        }
+        if (errors.size() > MAX_REPORTED_ERRORS) cerr << "Warning: " << path << ": " << errors.size() - MAX_REPORTED_ERRORS << " more malformed lines skipped." << endl;
+        records = ownedRecords.data();
+        blob = owned.data();
+        blobSize = owned.size();
+        count = ownedRecords.size();
+        return count > 0;
     }
 
-    ~GestureTracker() {
-        stopCamera();
+    size_t size() const override { return count; }
+
+    // Bytes held for the questions: the text buffer and records, or the whole mapping
+    size_t memoryBytes() const { return owned.empty() ? mapped.size() : owned.capacity() + ownedRecords.capacity() * sizeof(BankRecord); }
+
+    QuestionView operator[](size_t index) const override {
+        const BankRecord& r = records[index];
+        QuestionView q;
+        q.text = slice(r.textOffset, r.textLength);
+        for (int i = 0; i < 4; i++) q.options[i] = slice(r.optionOffset[i], r.optionLength[i]);
+        q.correctAnswerIndex = r.correctAnswerIndex < 4 ? (int)r.correctAnswerIndex : 0;
+        return q;
     }
 
-    void setEnabled(bool enabled) {
-        if (enabled) {
-            if (!cap.isOpened()) {
-                cap.open(0); // Try default
-                if (!cap.isOpened()) cap.open(1); // Try secondary
-            }
-        }
-        else {
-            stopCamera();
+    // Any open bank to the compiled layout, identical strings (common options like "Error") are stored once.
+    // Empty when the blob would not fit 32-bit offsets
+    static vector<char> compile(const QuestionBank& source) {
+        vector<BankRecord> table(source.size());
+        string blob;
+        unordered_map<string_view, uint32_t> stored; // Keys point into the source bank
+        auto addString = [&](string_view s, uint32_t& offset, uint32_t& length) {
+            auto [it, added] = stored.try_emplace(s, (uint32_t)blob.size());
+            if (added) blob += s;
+            offset = it->second;
+            length = (uint32_t)s.size();
+        };
+        for (size_t i = 0; i < source.size(); i++) {
+            QuestionView q = source[i];
+            addString(q.text, table[i].textOffset, table[i].textLength);
+            for (int k = 0; k < 4; k++) addString(q.options[k], table[i].optionOffset[k], table[i].optionLength[k]);
+            table[i].correctAnswerIndex = (uint32_t)q.correctAnswerIndex;
+            if (blob.size() > UINT32_MAX) return {};
         }
+        BankHeader header{};
+        header.magic = FILE_MAGIC;
+        header.version = VERSION;
+        header.questionCount = (uint32_t)table.size();
+        header.recordSize = sizeof(BankRecord);
+        header.recordsOffset = sizeof(BankHeader);
+        header.blobOffset = header.recordsOffset + table.size() * sizeof(BankRecord);
+        header.blobSize = blob.size();
+        vector<char> out(header.blobOffset + blob.size());
+        memcpy(out.data(), &header, sizeof(header));
+        if (!table.empty()) memcpy(out.data() + header.recordsOffset, table.data(), table.size() * sizeof(BankRecord));
+        if (!blob.empty()) memcpy(out.data() + header.blobOffset, blob.data(), blob.size());
+        return out;
     }
 
-    void stopCamera() {
-        if (cap.isOpened()) cap.release();
-        if (isWindowOpen) {
-            try { destroyWindow("Gesture Control"); }
-            catch (...) {}
-            isWindowOpen = false;
-        }
+private:
+    static constexpr size_t MAX_REPORTED_ERRORS = 20;
+    MappedFile mapped;
+    vector<char> owned; // Text bank file contents (unescaped in place), the mapping is unused then
+    vector<BankRecord> ownedRecords;
+    const BankRecord* records = nullptr;
+    const char* blob = nullptr;
+    uint64_t blobSize = 0;
+    size_t count = 0;
+
+    void reset() {
+        mapped.close();
+        owned.clear();
+        ownedRecords.clear();
+        records = nullptr;
+        blob = nullptr;
+        blobSize = 0;
+        count = 0;
     }
 
-    void update(float dt, bool isActive) {
-        if (!cap.isOpened()) return;
-        if (!isActive) {
-            if (isWindowOpen) {
-                try {
-                    destroyWindow("Gesture Control");
-                }
-                catch (...) {}
-                isWindowOpen = false;
+    // Header checks only, records are bounds-checked when read
+    bool attach(const char* data, size_t size) {
+        if (size < sizeof(BankHeader)) return false;
+        BankHeader h;
+        memcpy(&h, data, sizeof(h));
+        if (h.magic != FILE_MAGIC || h.version != VERSION || h.recordSize != sizeof(BankRecord)) return false;
+        if (h.recordsOffset % alignof(BankRecord) != 0) return false;
+        if (h.recordsOffset > size || (size - h.recordsOffset) / sizeof(BankRecord) < h.questionCount) return false;
+        if (h.blobOffset > size || h.blobSize > size - h.blobOffset) return false;
+        records = reinterpret_cast<const BankRecord*>(data + h.recordsOffset);
+        blob = data + h.blobOffset;
+        blobSize = h.blobSize;
+        count = h.questionCount;
+        return true;
+    }
+
+    string_view slice(uint32_t offset, uint32_t length) const {
+        if ((uint64_t)offset + length > blobSize) return {}; // Corrupt record, show nothing rather than read past the blob
+        return { blob + offset, length };
+    }
+};
+
+// Resident form of a text bank. Every distinct string is stored once in one arena (banks repeat options like "Error",
+// "0" or "None" all the time) and questions are fixed-size string ids kept as columns. Built from a loaded text
+// bank, which can be closed afterwards. Compiled banks are deduplicated already and are read from their mapping instead
+class QuestionStore : public QuestionSource {
+public:
+    QuestionStore() = default;
+    QuestionStore(const QuestionStore&) = delete;
+    QuestionStore& operator=(const QuestionStore&) = delete;
+
+    // False when the bank is empty or its distinct strings would not fit 32-bit offsets
+    bool build(const QuestionBank& source) {
+        clear();
+        size_t n = source.size();
+        textId.reserve(n);
+        for (auto& column : optionId) column.reserve(n);
+        answer.reserve(n);
+        unordered_map<string_view, uint32_t> ids; // Keys point into the source bank
+        ids.reserve(n * 2);
+        auto intern = [&](string_view s) {
+            auto [it, added] = ids.try_emplace(s, (uint32_t)stringEnd.size());
+            if (added) {
+                arena.insert(arena.end(), s.begin(), s.end());
+                stringEnd.push_back((uint32_t)arena.size());
+            }
+            return it->second;
+        };
+        for (size_t i = 0; i < n; i++) {
+            QuestionView q = source[i];
+            textId.push_back(intern(q.text));
+            for (int k = 0; k < 4; k++) optionId[k].push_back(intern(q.options[k]));
+            answer.push_back((uint8_t)q.correctAnswerIndex);
+            if (arena.size() > UINT32_MAX) {
+                clear();
+                return false;
             }
-            return;
         }
-        Mat frame, hsv, mask, drawing;
-        cap >> frame;
-        if (frame.empty()) return;
+        arena.shrink_to_fit();
+        stringEnd.shrink_to_fit();
+        return !textId.empty();
+    }
 
-        // Flip frame for mirror effect
-        flip(frame, frame, 1);
+    size_t size() const override { return textId.size(); }
+    size_t stringCount() const { return stringEnd.size(); }
 
-        // Define Region of Interest (ROI) - User puts hand in a box
-        // Using a fixed box ensures better lighting consistency
-        cv::Rect roiRect(50, 50, 300, 300);
-        rectangle(frame, roiRect, Scalar(255, 0, 0), 2);
+    QuestionView operator[](size_t index) const override {
+        QuestionView q;
+        q.text = text(textId[index]);
+        for (int k = 0; k < 4; k++) q.options[k] = text(optionId[k][index]);
+        q.correctAnswerIndex = answer[index];
+        return q;
+    }
+
+    // Heap bytes held, allocator overhead not counted
+    size_t memoryBytes() const {
+        size_t bytes = arena.capacity() + stringEnd.capacity() * sizeof(uint32_t) + textId.capacity() * sizeof(uint32_t) + answer.capacity();
+        for (const auto& column : optionId) bytes += column.capacity() * sizeof(uint32_t);
+        return bytes;
+    }
 
-        Mat roi = frame(roiRect);
+private:
+    vector<char> arena;
+    vector<uint32_t> stringEnd; // String i is arena[stringEnd[i - 1] (0 for the first), stringEnd[i])
+    vector<uint32_t> textId;
+    array<vector<uint32_t>, 4> optionId;
+    vector<uint8_t> answer;
+
+    void clear() {
+        arena.clear();
+        stringEnd.clear();
+        textId.clear();
+        for (auto& column : optionId) column.clear();
+        answer.clear();
+    }
 
-        // 1. Convert to HSV for skin detection
-        cvtColor(roi, hsv, COLOR_BGR2HSV);
+    string_view text(uint32_t id) const {
+        uint32_t begin = id ? stringEnd[id - 1] : 0;
+        return { arena.data() + begin, stringEnd[id] - begin };
+    }
+};
 
-        // 2. Threshold for Skin Color (Generic values, might need tweaking based on lighting)
-        // Lower: (0, 20, 70), Upper: (20, 255, 255) covers most skin tones
-        Scalar lowerSkin(0, 20, 70);
-        Scalar upperSkin(20, 255, 255);
-        inRange(hsv, lowerSkin, upperSkin, mask);
+// Fills out with k distinct indices below n in random order (a partial Fisher-Yates over the virtual array 0..n-1).
+// Small samples only remember the slots they swapped, so a 10 question quiz costs the same from any bank size
+void sampleIndices(uint32_t n, uint32_t k, mt19937& rng, vector<uint32_t>& out) {
+    k = min(k, n);
+    out.resize(k);
+    if (k == 0) return;
+    if (k >= n / 4) { // Most of the bank, a real array is cheaper than the map
+        vector<uint32_t> all(n);
+        iota(all.begin(), all.end(), 0u);
+        for (uint32_t i = 0; i < k; i++) swap(all[i], all[uniform_int_distribution<uint32_t>(i, n - 1)(rng)]);
+        copy_n(all.begin(), k, out.begin());
+        return;
+    }
+    unordered_map<uint32_t, uint32_t> moved; // Slot -> value, for slots that are not holding their own index anymore
+    moved.reserve(k * 2);
+    auto valueAt = [&](uint32_t slot) {
+        auto it = moved.find(slot);
+        return it == moved.end() ? slot : it->second;
+        };
+    for (uint32_t i = 0; i < k; i++) {
+        uint32_t j = uniform_int_distribution<uint32_t>(i, n - 1)(rng);
+        out[i] = valueAt(j);
+        moved[j] = valueAt(i); // Slot i is never read again
+    }
+}
 
-        // 3. Clean up noise (Erosion/Dilation)
-        erode(mask, mask, Mat(), Point(-1, -1), 2);
-        dilate(mask, mask, Mat(), Point(-1, -1), 2);
-        GaussianBlur(mask, mask, Size(5, 5), 0);
+// Every difficulty bank, loaded once on a background thread and kept resident. The game asks per difficulty and gets
+// either a ready bank or "still loading", it never waits on the disk. A bank that is missing falls back to a shared one
+class QuestionRepository {
+public:
+    enum class Status { Loading, Ready, Missing };
 
-        // 4. Find Contours
-        vector<vector<Point>> contours;
-        findContours(mask, contours, RETR_TREE, CHAIN_APPROX_SIMPLE);
+    explicit QuestionRepository(const vector<string>& files, string fallbackFile = "questions.txt") : fallbackFile(move(fallbackFile)) {
+        for (const string& file : files) {
+            slots.push_back(make_unique<Slot>());
+            slots.back()->file = file;
+        }
+    }
 
-        int count = 0;
+    ~QuestionRepository() {
+        if (loader.joinable()) loader.join();
+    }
 
-        if (!contours.empty()) {
-            // Find largest contour (assumed to be the hand)
-            size_t maxIdx = 0;
-            double maxArea = 0;
-            for (size_t i = 0; i < contours.size(); i++) {
-                double area = contourArea(contours[i]);
-                if (area > maxArea) {
-                    maxArea = area;
-                    maxIdx = i;
-                }
-            }
+    void startLoading() {
+        if (!loader.joinable()) loader = thread(&QuestionRepository::loadAll, this);
+    }
 
-            // Only process if the hand is big enough
-            if (maxArea > 3000) {
-                vector<Point> maxContour = contours[maxIdx];
+    Status status(size_t index) const { return slots[index]->status.load(memory_order_acquire); }
 
-                // Convex Hull
-                vector<int> hullIndices;
-                convexHull(maxContour, hullIndices, false);
+    // Null unless the bank is Ready
+    const QuestionSource* get(size_t index) const {
+        return status(index) == Status::Ready ? slots[index]->source : nullptr;
+    }
 
-                // Convexity Defects (The gaps between fingers)
-                vector<Vec4i> defects;
-                if (hullIndices.size() > 3) {
-                    convexityDefects(maxContour, hullIndices, defects);
+private:
+    // One bank in whichever form it was found
+    struct Resident {
+        QuestionBank compiled;
+        QuestionStore store;
+
+        // A compiled bank next to the text file (easy.txt -> easy.qbk) is served straight from its mapping,
+        // otherwise the text is parsed and packed into the store
+        const QuestionSource* open(const string& filename) {
+            if (compiled.openCompiled(filesystem::path(filename).replace_extension(".qbk").string())) return &compiled;
+            QuestionBank text; // Only needed while the store is built
+            if (text.loadText(filename) && store.build(text)) return &store;
+            return nullptr;
+        }
+    };
+    struct Slot {
+        string file;
+        Resident bank;
+        const QuestionSource* source = nullptr; // Inside bank, or the fallback
+        atomic<Status> status{ Status::Loading };
+    };
+    vector<unique_ptr<Slot>> slots;
+    string fallbackFile;
+    Resident fallback; // Loader thread only until a slot pointing at it is published
+    thread loader;
+
+    void loadAll() {
+        const QuestionSource* fallbackSource = nullptr;
+        bool fallbackTried = false;
+        for (auto& slot : slots) {
+            slot->source = slot->bank.open(slot->file);
+            if (!slot->source) {
+                cout << "Could not find " << slot->file << ", trying fallback '" << fallbackFile << "'..." << endl;
+                if (!fallbackTried) {
+                    fallbackTried = true;
+                    fallbackSource = fallback.open(fallbackFile);
+                }
+                slot->source = fallbackSource;
+            }
+            slot->status.store(slot->source ? Status::Ready : Status::Missing, memory_order_release); // Publishes the bank
+        }
+    }
+};
 
-                    for (const auto& v : defects) {
-                        float depth = (float)v[3] / 256.0f;
-                        if (depth > 10) { // Filter shallow defects (noise)
-                            int startIdx = v[0];
-                            int endIdx = v[1];
-                            int farIdx = v[2];
+// --------------------------------------------------------
+//            SCORE STORE (Leaderboards, Write-Behind)
+// --------------------------------------------------------
 
-                            Point pStart = maxContour[startIdx];
-                            Point pEnd = maxContour[endIdx];
-                            Point pFar = maxContour[farIdx];
+struct ScoreEntry {
+    int score = 0;
+    int questions = 0; // How many questions the quiz had
+    int64_t timestamp = 0; // Unix seconds when the quiz ended
+};
 
-                            // Cosine Law to check angle (fingers are usually sharp angles)
-                            double a = norm(pEnd - pStart);
-                            double b = norm(pFar - pStart);
-                            double c = norm(pFar - pEnd);
-                            double angle = acos((b * b + c * c - a * a) / (2 * b * c)) * 180 / CV_PI;
+// Per-difficulty top-K boards, loaded once and kept in memory. Changes are handed to a writer thread
+// that saves them to a temp file and renames it over the old one, so the game never waits on the disk
+// and a crash mid-write never leaves a half-written file
+class ScoreStore {
+public:
+    static constexpr int TOP_K = 10;
+    static constexpr const char* LEGACY_PATH = "highscore.txt"; // Single number from older versions
 
-                            // If angle is acute (< 90), it's likely a finger gap
-                            if (angle <= 90) {
-                                count++;
-                            }
-                        }
-                    }
-                }
-                // Logic: 0 defects = 1 finger (pointing) or fist.
-                // Let's assume 1 finger minimum if area is large.
-                // Formula: Fingers = Gaps + 1
-                detectedFingers = count + 1;
+    explicit ScoreStore(string path = "scores.txt") : path(move(path)) {}
 
-                // Cap at 5
-                if (detectedFingers > 5) detectedFingers = 5;
-            }
-            else {
-                detectedFingers = 0; // Hand not found
-            }
-        }
-        else {
-            detectedFingers = 0;
+    ~ScoreStore() {
+        {
+            lock_guard<mutex> lock(pendingMutex);
+            stopping = true;
         }
+        wake.notify_one();
+        if (writer.joinable()) writer.join(); // Writes whatever is still queued first
+    }
 
-        // 5. Stability Logic (Must hold gesture to trigger)
-        if (detectedFingers == lastStableCount && detectedFingers > 0) {
-            holdTime += dt;
-            if (holdTime >= REQUIRED_HOLD_TIME) {
-                triggerAction = true;
-                // Draw Green text indicating locked
-                putText(frame, "LOCKED: " + to_string(detectedFingers), Point(50, 40), FONT_HERSHEY_SIMPLEX, 1, Scalar(0, 255, 0), 2);
+    // Startup only: reads the score file, or imports the old highscore.txt if there is none yet
+    void load() {
+        ifstream file(path);
+        if (!file.is_open()) {
+            ifstream legacy(LEGACY_PATH);
+            int legacyScore = 0;
+            if (legacy >> legacyScore && legacyScore > 0) {
+                boards["All"].push_back({ legacyScore, 0, 0 });
+                queueWrite();
             }
-            else {
-                triggerAction = false;
-                // Draw Yellow text indicating loading
-                putText(frame, "Hold: " + to_string(detectedFingers), Point(50, 40), FONT_HERSHEY_SIMPLEX, 1, Scalar(0, 255, 255), 2);
+            return;
+        }
+        string line;
+        int lineNumber = 0;
+        while (getline(file, line)) {
+            lineNumber++;
+            if (line.empty() || line[0] == '#') continue;
+            // difficulty <TAB> score <TAB> questions <TAB> timestamp
+            stringstream ss(line);
+            string difficulty;
+            ScoreEntry entry;
+            if (!getline(ss, difficulty, '\t') || !(ss >> entry.score >> entry.questions >> entry.timestamp)) {
+                cerr << "Warning: Skipping malformed line " << lineNumber << " in " << path << "." << endl;
+                continue;
             }
+            insert(boards[difficulty], entry);
         }
-        else {
-            lastStableCount = detectedFingers;
-            holdTime = 0;
-            triggerAction = false;
-            line(frame, Point(50, 80), Point(50 + (holdTime / REQUIRED_HOLD_TIME) * 200, 80), Scalar(0, 255, 255), 5);
-            putText(frame, "Detecting...", Point(50, 40), FONT_HERSHEY_SIMPLEX, 1, Scalar(0, 0, 255), 2);
+    }
+
+    // Adds a finished quiz, returns its 1-based rank on that difficulty's board (0 = did not make it)
+    int record(const string& difficulty, int score, int questions) {
+        ScoreEntry entry{ score, questions, (int64_t)time(nullptr) };
+        int rank = insert(boards[difficulty], entry);
+        if (rank > 0) queueWrite(); // Nothing to save when the board did not change
+        return rank;
+    }
+
+    int best(const string& difficulty) const {
+        auto it = boards.find(difficulty);
+        return it == boards.end() || it->second.empty() ? 0 : it->second.front().score;
+    }
+
+    int bestOverall() const {
+        int top = 0;
+        for (const auto& [difficulty, board] : boards) {
+            if (!board.empty()) top = max(top, board.front().score);
         }
+        return top;
+    }
 
-        // Show the camera view in a separate small window
-        imshow("Gesture Control", frame);
-        isWindowOpen = true;
+    const vector<ScoreEntry>& board(const string& difficulty) const {
+        static const vector<ScoreEntry> empty;
+        auto it = boards.find(difficulty);
+        return it == boards.end() ? empty : it->second;
     }
 
-    // Returns true ONE time when the gesture is locked, then resets
-    bool consumeTrigger(int& outFingerCount) {
-        if (triggerAction) {
-            outFingerCount = lastStableCount;
-            // Reset to prevent machine-gun triggering
-            holdTime = 0;
-            triggerAction = false;
-            return true;
+private:
+    string path;
+    map<string, vector<ScoreEntry>> boards; // Each sorted best first, at most TOP_K long
+    thread writer;
+    mutex pendingMutex;
+    condition_variable wake;
+    string pending; // Newest serialized snapshot, older ones are simply replaced
+    bool hasPending = false;
+    bool stopping = false;
+
+    // Higher score first, ties go to the earlier entry
+    static int insert(vector<ScoreEntry>& board, const ScoreEntry& entry) {
+        auto at = upper_bound(board.begin(), board.end(), entry, [](const ScoreEntry& a, const ScoreEntry& b) { return a.score > b.score; });
+        int rank = (int)(at - board.begin()) + 1;
+        if (rank > TOP_K) return 0;
+        board.insert(at, entry);
+        if ((int)board.size() > TOP_K) board.pop_back();
+        return rank;
+    }
+
+    string serialize() const {
+        ostringstream out;
+        out << "# difficulty\tscore\tquestions\ttimestamp\n";
+        for (const auto& [difficulty, board] : boards) {
+            for (const ScoreEntry& e : board) out << difficulty << '\t' << e.score << '\t' << e.questions << '\t' << e.timestamp << '\n';
         }
-        return false;
+        return out.str();
+    }
+
+    // Render thread: snapshot the boards and wake the writer (starts it the first time)
+    void queueWrite() {
+        string snapshot = serialize();
+        {
+            lock_guard<mutex> lock(pendingMutex);
+            pending = move(snapshot);
+            hasPending = true;
+        }
+        if (!writer.joinable()) writer = thread(&ScoreStore::writerLoop, this);
+        wake.notify_one();
     }
-};
 
+    void writerLoop() {
+        unique_lock<mutex> lock(pendingMutex);
+        while (true) {
+            wake.wait(lock, [this] { return hasPending || stopping; });
+            if (!hasPending) return; // Stopping with nothing left to write
+            string contents = move(pending);
+            hasPending = false;
+            lock.unlock();
+            if (!writeAtomically(contents)) cerr << "Warning: Could not save scores to " << path << "." << endl;
+            lock.lock();
+        }
+    }
 
+    bool writeAtomically(const string& contents) const {
+        string tempPath = path + ".tmp";
+        {
+            ofstream out(tempPath, ios::binary | ios::trunc);
+            if (!out.write(contents.data(), (streamsize)contents.size()) || !out.flush()) return false;
+        }
+        error_code ec;
+        filesystem::rename(tempPath, path, ec); // Replaces the old file in one step
+        return !ec;
+    }
+};
 
 
 //Rounded Corner Buttons
@@ -332,28 +3229,39 @@ private:
 class OptionButton {
 public:
     RoundedRectangleShape shape;
-    Text text; // Options Text
-    Text prefix; // Options Number (A. B. C. D.)
+    UiLabel text; // Options Text
+    UiLabel prefix; // Options Number (A. B. C. D.)
     Color baseFillColor = UI_BASE_COLOR; // The Backgorund of Buttons
     Color baseOutlineColor = DEFAULT_OUTLINE_COLOR; // The Border of Buttons
     Vector2f originalPos;
     OptionButton(float x, float y, float w, float h, const string& prefixText, const Font& font);
     void update(Vector2i mousePos);
-    void setOptionText(const string& optionText);
+    void setOptionText(string_view optionText);
     void setColor(const Color& color) { shape.setFillColor(color); shape.setOutlineColor(color); }
     void resetColor() { shape.setFillColor(baseFillColor); shape.setOutlineColor(baseOutlineColor); }
     bool isClicked(Vector2i mousePos) const {
         return shape.getGlobalBounds().contains(static_cast<Vector2f>(mousePos));
     }
-    void draw(RenderWindow& window) const;
+    void draw(RenderTarget& window) const;
     void setPosition(const Vector2f& pos);
+    // Changes whenever the button would draw differently (hover, color, caption, position)
+    uint64_t signature() const {
+        uint64_t h = foldHash(text.signature(), prefix.signature());
+        h = foldHash(foldHash(h, shape.getFillColor()), shape.getOutlineColor());
+        return foldHash(foldHash(h, shape.getOutlineThickness()), shape.getPosition());
+    }
+private:
+    void placeText();
 };
 
 // Function Declarations
-int getHighScore();
-void saveHighScore(int currentScore);
-void spawnParticles(vector<Particle>& particles, Vector2f pos, Color color);
-vector<QuizQuestion> loadQuestionsFromFile(const string& filename);
+void spawnParticles(ParticlePool& particles, Vector2f pos, Color color);
+int runBankCompiler(int argc, char* argv[]);
+int runParserBenchmark(int argc, char* argv[]);
+int runStoreBenchmark(int argc, char* argv[]);
+int runGestureBenchmark(int argc, char* argv[]);
+int runGestureVerification(int argc, char* argv[]);
+int runGestureEvaluation(int argc, char* argv[]);
 
 
 
@@ -364,12 +3272,65 @@ vector<QuizQuestion> loadQuestionsFromFile(const string& filename);
 --------------------------------------------------------------------------------------------------*/
 
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Headless tools, run without opening a window
+    if (argc > 1 && string(argv[1]) == "--compile-bank") return runBankCompiler(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--bench-parser") return runParserBenchmark(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--bench-store") return runStoreBenchmark(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--bench-gesture") return runGestureBenchmark(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--verify-gesture") return runGestureVerification(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--eval-gesture") return runGestureEvaluation(argc, argv);
+
+    // Command line: --gesture-source <camera[:N] | video:<file> | images:<dir> | synthetic[:N]> [--fixed-roi] [--gesture-scale 1|2|4] [--gesture-rate <hz, 0 = every frame>] [--no-preview]
+    //               [--profile-csv <file>] [--vote-window <s>] [--vote-threshold <0..1>]
+    //               [--skin-table <file>] [--no-layer-cache] [--no-idle-governor]
+    string gestureSourceSpec = "camera";
+    bool gestureTracking = true;
+    int gestureScale = 1;
+    double gestureRate = 30.0;
+    PreviewMode previewMode = PreviewMode::Embedded;
+    string profileCsvPath = "frame_profile.csv";
+    double voteWindow = GestureTracker::REQUIRED_HOLD_TIME;
+    double voteThreshold = FingerVoteFilter().threshold;
+    string skinTablePath = "skin_table.bin";
+    bool layerCacheEnabled = true;
+    bool idleGovernorEnabled = true;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--gesture-source" && i + 1 < argc) gestureSourceSpec = argv[++i];
+        else if (arg == "--fixed-roi") gestureTracking = false;
+        else if (arg == "--gesture-scale" && i + 1 < argc) gestureScale = atoi(argv[++i]);
+        else if (arg == "--gesture-rate" && i + 1 < argc) gestureRate = atof(argv[++i]);
+        else if (arg == "--no-preview") previewMode = PreviewMode::None;
+        else if (arg == "--profile-csv" && i + 1 < argc) profileCsvPath = argv[++i];
+        else if (arg == "--vote-window" && i + 1 < argc) voteWindow = atof(argv[++i]);
+        else if (arg == "--vote-threshold" && i + 1 < argc) voteThreshold = atof(argv[++i]);
+        else if (arg == "--skin-table" && i + 1 < argc) skinTablePath = argv[++i];
+        else if (arg == "--no-layer-cache") layerCacheEnabled = false;
+        else if (arg == "--no-idle-governor") idleGovernorEnabled = false;
+    }
+    double maxVoteWindow = FingerVoteFilter::maxWindow(max(0.0, gestureRate));
+    if (voteWindow < 0 || voteWindow > maxVoteWindow) {
+        voteWindow = std::clamp(voteWindow, 0.0, maxVoteWindow);
+        cerr << "Warning: --vote-window must be between 0 and " << maxVoteWindow << " s at this gesture rate, using " << voteWindow << " s." << endl;
+    }
+    if (voteThreshold < 0 || voteThreshold > 1) {
+        voteThreshold = std::clamp(voteThreshold, 0.0, 1.0);
+        cerr << "Warning: --vote-threshold must be between 0 and 1, using " << voteThreshold << "." << endl;
+    }
+
     //Rendering Window
     RenderWindow window(VideoMode({ WINDOW_WIDTH, WINDOW_HEIGHT }), "C++ Logic Builder");
     window.setFramerateLimit(60);
     srand(static_cast<unsigned>(time(0)));
     GestureTracker gestureTracker;
+    if (auto source = makeFrameSource(gestureSourceSpec, FramePacing::RealTime)) gestureTracker.setSource(move(source));
+    gestureTracker.setTracking(gestureTracking);
+    gestureTracker.setScale(gestureScale);
+    gestureTracker.setDetectionRate(gestureRate);
+    gestureTracker.setPreviewMode(previewMode);
+    gestureTracker.setVoteFilter(voteWindow, voteThreshold);
+    gestureTracker.setSkinTablePath(skinTablePath);
 
     //Streak on correct Answers
     int comboStreak = 0;
@@ -386,6 +3347,13 @@ int main() {
     float musicVolume = 50.0f;
     bool cameraEnabled = true;
 
+    // Leaderboards are read once here, after that only the store's writer thread touches the file
+    ScoreStore scores;
+    scores.load();
+    bool scoreRecorded = true; // Cleared when a quiz starts, set once its result is in the store
+    int lastRank = 0; // Leaderboard place of the last finished quiz (0 = not on the board)
+    gestureTracker.setEnabled(cameraEnabled); // Camera thread starts right away, game never waits for it
+
     // Load Resources
     
     Font uifont; // UI Font
@@ -402,6 +3370,8 @@ int main() {
     if (!titleFont.openFromFile("Orbitron.ttf")) { // Loading Title (Easy mode, etc.) Font Orbitron
         titleFont = uifont;
     }
+
+    FrameProfiler profiler(uifont); // F2 shows the overlay, CSV is written on exit
     Texture backgroundTexture;
     unique_ptr<Sprite> backgroundSprite; // Smart pointer to kill the bg img when it dies/ Saves memory
     if (backgroundTexture.loadFromFile("download.jpg")) { // Loading the background image
@@ -434,7 +3404,13 @@ int main() {
     }
 
     // Global State Variables
-    vector<QuizQuestion> allQuestions;  // Holds all the questions from all files
+    QuestionRepository questionBanks({ "easy.txt", "medium.txt", "hard.txt" }); // Same order as DIFFICULTY_NAMES
+    questionBanks.startLoading(); // Ready long before the player gets to the difficulty screen
+    const QuestionSource* bank = nullptr; // Questions of the selected difficulty, owned by questionBanks
+    int pendingDifficulty = -1; // Picked while its bank was still loading
+    mt19937 quizRng(random_device{}()); // Seeded once, picks the questions of every quiz
+    vector<uint32_t> quizOrder; // Bank index of each question in this quiz
+    vector<int> selectedAnswers; // What the user picked per quiz question (-1 means nothing)
     unsigned int currentQuestionIndex = 0;
     GameState currentState = MENU;
     int score = 0;
@@ -457,15 +3433,30 @@ int main() {
     //timerBar.setSize({ (float)WINDOW_WIDTH, 10.f });
     //timerBar.setFillColor(Color::Green); // Timer Bar color in the beginning
 
-    vector<Particle> particles;
-    vector<FloatingText> floatTexts;
+    // Camera Preview (below the Cam button), texture is sized once and updated in place
+    Texture previewTexture;
+    bool previewAvailable = previewTexture.resize({ (unsigned)PREVIEW_SIZE, (unsigned)PREVIEW_SIZE });
+    if (!previewAvailable) cerr << "Warning: Could not create the camera preview texture." << endl;
+    Sprite previewSprite(previewTexture);
+    previewSprite.setPosition({ 20.f, 100.f });
+    RectangleShape previewFrame({ (float)PREVIEW_SIZE, (float)PREVIEW_SIZE });
+    previewFrame.setPosition({ 20.f, 100.f });
+    previewFrame.setFillColor(Color::Transparent);
+    previewFrame.setOutlineThickness(3);
+    RectangleShape previewHoldBar({ 0.f, 6.f }); // Fills up while a gesture is held
+    previewHoldBar.setPosition({ 20.f, 100.f + PREVIEW_SIZE + 4.f });
+    previewHoldBar.setFillColor(Color(255, 255, 0));
+    UiLabel previewLabel(uifont, "", 18);
+    previewLabel.setPosition({ 20.f, 100.f + PREVIEW_SIZE + 14.f });
+
+    ParticlePool particles;
+    FloatingTextPool floatTexts(uifont);
 
     // Custom Input Variables
     bool isTypingCustomAmount = false;
     string customInputString = "";
-    Text customInputDisplay(codeFont);
-    customInputDisplay.setCharacterSize(40);
-    customInputDisplay.setFillColor(Color(180, 200, 255));
+    UiLabel customInputDisplay(codeFont, "", 30, Color(180, 200, 255));
+    customInputDisplay.setAlignment({ 0.5f, 0.5f });
 
     bool isAnswerLocked = false;
     bool autoNext = false;
@@ -475,20 +3466,41 @@ int main() {
 
     /*--------------------------------------------  UI -----------------------------------------------*/
 
-    Text titleText(titleFont);
-    titleText.setString("C++ Logic Builder");
-    titleText.setCharacterSize(48);
-    titleText.setFillColor(Color(180, 200, 255)); // Bluish Color (Sky Blue)
-    FloatRect tr = titleText.getLocalBounds(); // Gets the length/picels of the text
-    titleText.setOrigin({ tr.position.x + tr.size.x / 2.0f, 0 }); // Move the origin to center
-    titleText.setPosition({ WINDOW_WIDTH / 2.0f, 60.0f });
+    // Labels keep their glyph geometry between frames, they are re-laid out only when a state is entered or a value changes
+    UiLabel titleText(titleFont, "C++ Logic Builder", 55, Color(180, 200, 255)); // Bluish Color (Sky Blue), set up per state in layoutUiState
+    UiLabel highScoreText(uifont, "", 30, Color::Yellow);
+    highScoreText.setShadow(Color(0, 0, 0, 150), { 4.0f, 4.0f });
+    highScoreText.setAlignment({ 0.5f, 0.f });
+    highScoreText.setPosition({ WINDOW_WIDTH / 2.0f, 50.0f });
+    UiLabel menuSubtitle(uifont, "MASTER THE SKILL!", 24);
+    menuSubtitle.setAlignment({ 0.5f, 0.f });
+    menuSubtitle.setPosition({ WINDOW_WIDTH / 2.0f, 220.f });
+    UiLabel credits(uifont, "Created by Muhammad Faizan | End Semester Project", 18);
+    credits.setAlignment({ 1.f, 1.f }); // Align to bottom-right
+    credits.setPosition({ WINDOW_WIDTH - 20.0f, WINDOW_HEIGHT - 20.0f });
+    UiLabel limitPrompt(uifont, "", 24);
+    limitPrompt.setAlignment({ 0.5f, 0.f });
+    limitPrompt.setPosition({ WINDOW_WIDTH / 2.0f, 230.0f });
+    UiLabel limitHint(uifont, "Type amount & Press ENTER", 18, Color::Yellow);
+    limitHint.setAlignment({ 0.5f, 0.f });
+    limitHint.setPosition({ WINDOW_WIDTH / 2.0f, 330.0f + 45.0f }); // Under the custom amount box
+    UiLabel pauseTitle(uifont, "PAUSED", 60);
+    pauseTitle.setAlignment({ 0.5f, 0.f });
+    pauseTitle.setPosition({ WINDOW_WIDTH / 2.0f, 150.0f });
+    UiLabel finalScore(uifont, "", 40);
+    finalScore.setAlignment({ 0.5f, 0.f });
+    finalScore.setPosition({ WINDOW_WIDTH / 2.0f, 230.0f });
+    UiLabel rankText(uifont, "", 24, Color::Yellow);
+    rankText.setShadow(Color(0, 0, 0, 150), { 3.0f, 3.0f });
+    rankText.setAlignment({ 0.5f, 0.f });
+    rankText.setPosition({ WINDOW_WIDTH / 2.0f, 470.0f }); // Under the buttons
 
     // Beginning
-    Text scoreText(uifont);
-    scoreText.setString("Score: 0");
-    scoreText.setCharacterSize(24);
+    UiLabel scoreText(uifont, "Score: 0", 24);
     scoreText.setPosition({ 10, WINDOW_HEIGHT - 40 }); // Shows the score on bottom
-    scoreText.setFillColor(Color::White);
+    bool scoreTextBuilt = false; // scoreText shows shownScore and shownQuestion
+    int shownScore = 0;
+    unsigned int shownQuestion = 0;
 
     Text questionText(codeFont);
     questionText.setString("Question text");
@@ -538,9 +3550,11 @@ int main() {
     backSettingsBtn.baseFillColor = Color(150, 50, 50, 200); // Dark Red but transparent
     backSettingsBtn.resetColor();
 
-    // Text to display volume number
-    Text volumeDisplay(uifont, "Vol: 50", 30);
-    volumeDisplay.setFillColor(Color::White);
+    // Text to display volume number, centered between the - and + buttons
+    UiLabel volumeDisplay(uifont, "Vol: 50", 30);
+    volumeDisplay.setAlignment({ 0.5f, 0.5f });
+    volumeDisplay.setPosition({ WINDOW_WIDTH / 2.0f, volDownBtn.shape.getPosition().y + volDownBtn.shape.getSize().y / 2.0f });
+    int shownVolume = 50;
 
 
     // DIFFICULTY SELECT
@@ -549,15 +3563,15 @@ int main() {
     OptionButton mediumBtn(WINDOW_WIDTH / 2 - 120, DIFF_BTN_Y + 80, 240, 60, "", uifont);
     OptionButton hardBtn(WINDOW_WIDTH / 2 - 120, DIFF_BTN_Y + 160, 240, 60, "", uifont);
 
-    easyBtn.setOptionText("Easy");
+    easyBtn.setOptionText(DIFFICULTY_LABELS[0]);
     easyBtn.baseFillColor = Color(50, 150, 50, 200); // Greenish Color
     easyBtn.resetColor();
 
-    mediumBtn.setOptionText("Medium");
+    mediumBtn.setOptionText(DIFFICULTY_LABELS[1]);
     mediumBtn.baseFillColor = Color(200, 150, 50, 200); // Orangish Color
     mediumBtn.resetColor();
 
-    hardBtn.setOptionText("Hard");
+    hardBtn.setOptionText(DIFFICULTY_LABELS[2]);
     hardBtn.baseFillColor = Color(150, 50, 50, 200); // Redish Color
     hardBtn.resetColor();
 
@@ -566,6 +3580,7 @@ int main() {
     customLimitBtn.setOptionText("Enter Desired Questions");
     customLimitBtn.baseFillColor = Color(100, 50, 100, 200);
     customLimitBtn.resetColor();
+    customInputDisplay.setPosition(customLimitBtn.shape.getPosition() + (customLimitBtn.shape.getSize() / 2.0f));
 
     OptionButton confirmLimitBtn(WINDOW_WIDTH / 2 + 160, 300, 100, 60, "", uifont);
     confirmLimitBtn.setOptionText("ENTER");
@@ -622,8 +3637,8 @@ int main() {
     // Helpers
     auto loadQuestion = [&]() { //[&] is the Capture List. It allows the fucntion to see and modify variables decaled outside
         if (currentQuestionIndex < actualTotalQuestions) {
-            const auto& q = allQuestions[currentQuestionIndex];
-            questionText.setString(q.questionText);
+            QuestionView q = (*bank)[quizOrder[currentQuestionIndex]];
+            questionText.setString(String::fromUtf8(q.text.begin(), q.text.end()));
             // Text Positioning
             FloatRect textBounds = questionText.getLocalBounds(); // Center the text
             questionText.setOrigin({ textBounds.position.x + textBounds.size.x / 2.0f, textBounds.position.y + textBounds.size.y / 2.0f });
@@ -634,11 +3649,12 @@ int main() {
                 options[i].resetColor();
             }
             // Checks if the question has been answered
-            if (q.userSelectedOption != -1) {
+            int selected = selectedAnswers[currentQuestionIndex];
+            if (selected != -1) {
                 isAnswerLocked = true;
                 options[q.correctAnswerIndex].setColor(CORRECT_COLOR); // Green
-                if (q.userSelectedOption != q.correctAnswerIndex)
-                    options[q.userSelectedOption].setColor(INCORRECT_COLOR); // Red
+                if (selected != q.correctAnswerIndex)
+                    options[selected].setColor(INCORRECT_COLOR); // Red
                 timeLeft = 0;
                 timerBar.setSize({ 0, 20.f });
                 autoNext = false;
@@ -664,56 +3680,179 @@ int main() {
     // Starts Game
     auto startGame = [&](int limit) {
         score = 0;
+        scoreRecorded = false;
         currentQuestionIndex = 0;
-        for (auto& q : allQuestions) { // Reset the memory for all questions
-            q.userSelectedOption = -1;
-        }
         actualTotalQuestions = min(limit, totalQuestions); // Limit is the number of questions user wants, it checks whether user's number is smaller than the actual present questions and chooses the min questions to save game from crashing
-        random_device rd; // Shuffling Seed
-        mt19937 g(rd()); // Randomizing generator for questions
-        shuffle(allQuestions.begin(), allQuestions.end(), g); // Shuffles all the questions
+        sampleIndices(static_cast<uint32_t>(min(bank->size(), (size_t)UINT32_MAX)), actualTotalQuestions, quizRng, quizOrder); // Picks only the questions played, the bank itself is read-only
+        selectedAnswers.assign(actualTotalQuestions, -1); // Reset the memory for all questions
         loadQuestion();
         currentState = QUIZ_MODE;
         isTypingCustomAmount = false;
         customInputString = "";
         };
 
-    // Switches files
-    auto selectDifficulty = [&](string filename, string displayName) {
-        allQuestions = loadQuestionsFromFile(filename);
-        if (allQuestions.empty()) {
-            cout << "Could not find " << filename << ", trying fallback 'questions.txt'..." << endl;
-            allQuestions = loadQuestionsFromFile("questions.txt");
-        }
+    RectangleShape pauseOverlay({ WINDOW_WIDTH, WINDOW_HEIGHT });
+    pauseOverlay.setFillColor(Color(0, 0, 0, 200));
 
-        if (allQuestions.empty()) { // All Files empty
+    // Menu-style screens are drawn into this layer only when something on them changed
+    ScreenLayer screenLayer;
+    if (layerCacheEnabled && !screenLayer.create({ WINDOW_WIDTH, WINDOW_HEIGHT })) cerr << "Warning: Could not create the screen layer, drawing every frame." << endl;
+
+    // Fade transitions
+    RectangleShape fadeRect({ (float)WINDOW_WIDTH, (float)WINDOW_HEIGHT });
+    fadeRect.setFillColor(Color::Black); // Starts fully black
+    float fadeAlpha = 255.0f;
+
+    // Lambda Function to trigger a flash
+    auto triggerFade = [&]() { fadeAlpha = 255.0f; };
+
+    // Switches banks, all of them are already in memory (or still loading, then the frame loop retries)
+    auto selectDifficulty = [&](int difficulty) {
+        QuestionRepository::Status status = questionBanks.status(difficulty);
+        if (status == QuestionRepository::Status::Loading) {
+            pendingDifficulty = difficulty;
+            return;
+        }
+        pendingDifficulty = -1;
+        triggerFade();
+        if (status == QuestionRepository::Status::Missing) { // All Files empty
             cerr << "CRITICAL: No questions found!" << endl;
             currentState = MENU;
             return;
         }
-        totalQuestions = static_cast<int>(allQuestions.size());
+        bank = questionBanks.get(difficulty);
+        totalQuestions = static_cast<int>(min(bank->size(), (size_t)INT_MAX));
         limitAllBtn.setOptionText("Play All (" + to_string(totalQuestions) + ")");
-        currentDifficultyName = displayName;
+        currentDifficultyName = DIFFICULTY_NAMES[difficulty];
         currentState = SET_LIMIT;
         };
 
-    // Fade transitions
-    RectangleShape fadeRect({ (float)WINDOW_WIDTH, (float)WINDOW_HEIGHT });
-    fadeRect.setFillColor(Color::Black); // Starts fully black
-    float fadeAlpha = 255.0f;
+    // Sets up the title and the shared buttons for the state being entered, the draw code only draws them
+    int uiState = -1;
+    auto layoutUiState = [&]() {
+        titleText.setCharacterSize(55);
+        titleText.setShadow(Color(0, 0, 0, 150), { 4.0f, 4.0f }); // Black with transparency Shadow effect, shifted down-right
+        titleText.setAlignment({ 0.5f, 0.5f });
+        titleText.setPosition({ WINDOW_WIDTH / 2.0f, 160.0f });
+        if (currentState == MENU) {
+            titleText.setString("C++ Logic Builder");
+            highScoreText.setString("High Score: " + to_string(scores.bestOverall()));
+            startBtn.setOptionText("Start Game");
+            startBtn.setPosition({ WINDOW_WIDTH / 2.0f - 120.0f, 300.0f });
+            settingsBtn.setPosition({ WINDOW_WIDTH / 2.0f - 120.0f, 380.0f });
+            exitBtn.setOptionText("Exit Game");
+            exitBtn.setPosition({ WINDOW_WIDTH / 2.0f - 120.0f, 460.0f });
+        }
+        else if (currentState == SETTINGS) {
+            titleText.setString("Audio Settings");
+        }
+        else if (currentState == SELECT_DIFFICULTY) {
+            titleText.setString("Select Difficulty");
+        }
+        else if (currentState == SET_LIMIT) {
+            titleText.setString(currentDifficultyName);
+            titleText.setShadow(Color(0, 0, 0, 180), { 5.0f, 5.0f }); // Dark semi-transparent black, 5 pixels down and right
+            titleText.setPosition({ WINDOW_WIDTH / 2.0f, 150.0f });
+            limitPrompt.setString("Questions Available: " + to_string(totalQuestions));
+        }
+        else if (currentState == QUIZ_MODE || currentState == PAUSED) {
+            titleText.setString(currentDifficultyName);
+            titleText.setShadow(Color(0, 0, 0, 150), { 3.0f, 3.0f });
+            titleText.setAlignment({ 0.5f, 0.f });
+            titleText.setPosition({ WINDOW_WIDTH / 2.0f, 60.0f });
+            scoreTextBuilt = false; // A new quiz may start at the same score and index
+            if (currentState == PAUSED) {
+                startBtn.setOptionText("Resume Game (Esc)");
+                startBtn.setPosition({ WINDOW_WIDTH / 2.0f - 120.0f, 300.0f });
+                endQuizBtn.setPosition({ WINDOW_WIDTH / 2.0f - 120.0f, 380.0f });
+                exitBtn.setOptionText("Exit to Main Menu");
+                exitBtn.setPosition({ WINDOW_WIDTH / 2.0f - 120.0f, 460.0f });
+            }
+        }
+        else if (currentState == GAME_OVER) {
+            titleText.setString("QUIZ COMPLETE!");
+            titleText.setCharacterSize(60);
+            titleText.setPosition({ WINDOW_WIDTH / 2.0f, 150.0f });
+            finalScore.setString("Final score: " + to_string(score) + " / " + to_string(actualTotalQuestions));
+            if (lastRank > 0) rankText.setString("#" + to_string(lastRank) + " on the " + currentDifficultyName + " leaderboard");
+            else rankText.setString("Best on " + currentDifficultyName + ": " + to_string(scores.best(currentDifficultyName)));
+            startBtn.setOptionText("Back to Menu");
+            startBtn.setPosition({ WINDOW_WIDTH / 2.0f - 120.0f, 300.0f });
+            exitBtn.setOptionText("Exit Game");
+            exitBtn.setPosition({ WINDOW_WIDTH / 2.0f - 120.0f, 380.0f });
+        }
+        };
+
+    // Everything on the menu-style screens, drawn into the screen layer (or straight to the window without one)
+    auto drawStaticScreen = [&](RenderTarget& window) {
+        if (currentState == MENU) {
+            window.draw(titleText);
+            window.draw(highScoreText);
+            window.draw(menuSubtitle);
+            startBtn.draw(window);
+            settingsBtn.draw(window);
+            exitBtn.draw(window);
+            window.draw(credits);
+        }
+        else if (currentState == SETTINGS) {
+            window.draw(titleText);
+            // Drawing all Buttons in Settings
+            toggleMusicBtn.draw(window);
+            toggleSfxBtn.draw(window);
+            toggleCamBtn.draw(window);
+            volDownBtn.draw(window);
+            window.draw(volumeDisplay);
+            volUpBtn.draw(window);
+            backSettingsBtn.draw(window);
+        }
+        else if (currentState == SELECT_DIFFICULTY) {
+            window.draw(titleText);
+            easyBtn.draw(window);
+            mediumBtn.draw(window);
+            hardBtn.draw(window);
+        }
+        else if (currentState == SET_LIMIT) {
+            window.draw(titleText);
+            window.draw(limitPrompt);
+
+            if (isTypingCustomAmount) {
+                window.draw(customLimitBtn.shape);
+                window.draw(customInputDisplay);
+                window.draw(limitHint);
+                confirmLimitBtn.draw(window);
+            }
+            else {
+                customLimitBtn.draw(window);
+            }
+            limitAllBtn.draw(window);
+        }
+        else if (currentState == GAME_OVER) {
+            window.draw(titleText);
+            window.draw(finalScore);
+            window.draw(rankText);
+            startBtn.draw(window);
+            exitBtn.draw(window);
+        }
+        };
 
-    // Lambda Function to trigger a flash
-    auto triggerFade = [&]() { fadeAlpha = 255.0f; };
+    // Idle menus tick at FrameGovernor::IDLE_FPS instead of 60 fps
+    FrameGovernor governor;
+    governor.enabled = idleGovernorEnabled;
 
     // Main Game Loop
     while (window.isOpen()) {
+        optional<Event> waitedEvent = governor.wait(window); // Blocks only while idle, not part of the profiled frame
+        bool hadInput = waitedEvent.has_value();
+
         // Calculate Delta Time (dt)
         Time dtTime = dtClock.restart();
         float dt = dtTime.asSeconds();
+        profiler.beginFrame(currentState);
 
-        gestureTracker.update(dt, (currentState == QUIZ_MODE));
+        gestureTracker.setActive(currentState == QUIZ_MODE); // Camera thread does the detection
         int gestureFingers = 0;
         bool gestureTriggered = gestureTracker.consumeTrigger(gestureFingers);
+        bool gestureFeedbackPending = false; // Set when the trigger changed what this frame shows
 
         // Calculate Background Pulse (Background Continuous Color Changing
         Time elapsed = effectClock.getElapsedTime();
@@ -727,7 +3866,8 @@ int main() {
 
         /*-----------------------------------------   Event Pollings  --------------------------------------------*/
 
-        while (const optional event = window.pollEvent()) { // Checks for Keyboard Input
+        while (const optional event = waitedEvent ? exchange(waitedEvent, nullopt) : window.pollEvent()) { // Checks for Keyboard Input
+            hadInput = true;
             if (event->is<Event::Closed>()) { window.close(); } // Checks for the closing 'X' click on the windows title bar
             // Text Entry
             if (currentState == SET_LIMIT && isTypingCustomAmount) { // User entered the button to type on set limit menu
@@ -748,10 +3888,12 @@ int main() {
             }
             // Key Presses
             if (const auto* keyEvent = event->getIf<Event::KeyPressed>()) { // Checks for keys being pressed
+                if (keyEvent->code == Keyboard::Key::F2) profiler.overlayVisible = !profiler.overlayVisible; // Frame time bars
+                if (keyEvent->code == Keyboard::Key::F3) gestureTracker.latency.print(cout); // Gesture latency percentiles so far
                 if (keyEvent->code == Keyboard::Key::Escape) { // Escape key is pressed
                     if (currentState == QUIZ_MODE) currentState = PAUSED; // Pauses the game
                     else if (currentState == PAUSED) currentState = QUIZ_MODE; // Resumes the game
-                    else if (currentState == SELECT_DIFFICULTY) currentState = MENU; // Returns to menu
+                    else if (currentState == SELECT_DIFFICULTY) { currentState = MENU; pendingDifficulty = -1; } // Returns to menu, dropping a pick still waiting on its bank
                     else if (currentState == SETTINGS) currentState = MENU;
                     else if (currentState == MENU) window.close();
                     else if (currentState == SET_LIMIT) {
@@ -769,6 +3911,9 @@ int main() {
                         else if (currentQuestionIndex == 0) currentQuestionIndex = 0;
                         loadQuestion();
                     }
+                    else if (keyEvent->code == Keyboard::Key::C) {
+                        gestureTracker.requestCalibration(); // Learn skin color from the hand in the box
+                    }
                 }
                 else if (currentState == SETTINGS) {
                     if (keyEvent->code == Keyboard::Key::Right) { // Volume Increase
@@ -857,16 +4002,13 @@ int main() {
                     }
                     else if (currentState == SELECT_DIFFICULTY) {
                         if (easyBtn.isClicked(mousePos)) {
-                            triggerFade();
-                            selectDifficulty("easy.txt", "Easy Mode");
+                            selectDifficulty(0);
                         }
                         else if (mediumBtn.isClicked(mousePos)) {
-                            triggerFade();
-                            selectDifficulty("medium.txt", "Medium Mode");
+                            selectDifficulty(1);
                         }
                         else if (hardBtn.isClicked(mousePos)) {
-                            triggerFade();
-                            selectDifficulty("hard.txt", "Hard Mode");
+                            selectDifficulty(2);
                         }
                     }
                     else if (currentState == SET_LIMIT) {
@@ -949,8 +4091,8 @@ int main() {
                         if (!isAnswerLocked) { // Preventss from selecting two options
                             for (int i = 0; i < 4; ++i) {
                                 if (options[i].isClicked(mousePos)) {
-                                    allQuestions[currentQuestionIndex].userSelectedOption = i; // Saves the selection to the memory
-                                    const auto& currentQ = allQuestions[currentQuestionIndex];
+                                    selectedAnswers[currentQuestionIndex] = i; // Saves the selection to the memory
+                                    QuestionView currentQ = (*bank)[quizOrder[currentQuestionIndex]];
                                     if (i == currentQ.correctAnswerIndex) { // Correct Answer
                                         score++;
                                         comboStreak++;
@@ -958,7 +4100,7 @@ int main() {
                                         correctSound.setPitch(pitch);
                                         options[i].setColor(CORRECT_COLOR); // Turns the button Green
                                         if (hasSound && sfxEnabled) correctSound.play(); // Play the correct Sound
-                                        floatTexts.emplace_back(uifont, "+1", static_cast<float>(mousePos.x), static_cast<float>(mousePos.y - 40)); // Shows the Floating Text
+                                        floatTexts.spawn("+1", static_cast<float>(mousePos.x), static_cast<float>(mousePos.y - 40)); // Shows the Floating Text
                                     }
                                     else { /// For incorrect answers
                                         options[i].setColor(INCORRECT_COLOR); // Turns the selected wrong answer Red
@@ -983,6 +4125,7 @@ int main() {
         }
 
         /*-----------------------------------------   Event Polling End  --------------------------------------------*/
+        profiler.lap(PHASE_INPUT);
 
         // --- NEW CODE: HANDLE GESTURE INPUTS ---
         if (gestureTriggered) {
@@ -992,6 +4135,7 @@ int main() {
             if (gestureFingers == 5) {
                 if (currentState == QUIZ_MODE) currentState = PAUSED;
                 else if (currentState == PAUSED) currentState = QUIZ_MODE;
+                gestureFeedbackPending = currentState == QUIZ_MODE || currentState == PAUSED;
             }
             // 1-4 FINGERS: SELECT ANSWER (Only in Quiz Mode)
             else if (currentState == QUIZ_MODE && !isAnswerLocked) {
@@ -1004,8 +4148,8 @@ int main() {
 
                 // Logic copied from your Mouse Click event
                 if (selectedIndex != -1) {
-                    allQuestions[currentQuestionIndex].userSelectedOption = selectedIndex;
-                    const auto& currentQ = allQuestions[currentQuestionIndex];
+                    selectedAnswers[currentQuestionIndex] = selectedIndex;
+                    QuestionView currentQ = (*bank)[quizOrder[currentQuestionIndex]];
 
                     if (selectedIndex == currentQ.correctAnswerIndex) {
                         // Correct
@@ -1016,7 +4160,7 @@ int main() {
                         options[selectedIndex].setColor(CORRECT_COLOR);
                         if (hasSound && sfxEnabled) correctSound.play();
                         // Floating text math...
-                        floatTexts.emplace_back(uifont, "+1", WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2);
+                        floatTexts.spawn("+1", WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2);
                     }
                     else {
                         // Incorrect
@@ -1032,9 +4176,11 @@ int main() {
                     isAnswerLocked = true;
                     autoNext = true;
                     feedbackTimer.restart();
+                    gestureFeedbackPending = true;
                 }
             }
         }
+        profiler.lap(PHASE_GESTURE);
 
         // Update Game Logic
 
@@ -1054,24 +4200,36 @@ int main() {
             volDownBtn.update(mPos);
             backSettingsBtn.update(mPos);
             // Update Volume Text Display
-            volumeDisplay.setString("Vol: " + to_string((int)musicVolume));
-            FloatRect vb = volumeDisplay.getLocalBounds();
-            // Position of the - and + buttons
-            float btnY = volDownBtn.shape.getPosition().y;
-            float btnH = volDownBtn.shape.getSize().y;
-            volumeDisplay.setOrigin({ vb.size.x / 2.0f, vb.size.y / 2.0f });
-            volumeDisplay.setPosition({ WINDOW_WIDTH / 2.0f, btnY + btnH / 2.0f
-                });
+            if ((int)musicVolume != shownVolume) {
+                shownVolume = (int)musicVolume;
+                volumeDisplay.setString("Vol: " + to_string(shownVolume));
+            }
         }
         else if (currentState == SELECT_DIFFICULTY) {
             easyBtn.update(mPos);
             mediumBtn.update(mPos);
             hardBtn.update(mPos);
+            // Banks still loading say so, a pick made meanwhile goes through as soon as its bank is ready
+            OptionButton* difficultyBtns[] = { &easyBtn, &mediumBtn, &hardBtn };
+            for (int d = 0; d < 3; d++) {
+                bool loading = questionBanks.status(d) == QuestionRepository::Status::Loading;
+                difficultyBtns[d]->setOptionText(loading ? "Loading..." : DIFFICULTY_LABELS[d]);
+            }
+            if (pendingDifficulty >= 0) selectDifficulty(pendingDifficulty);
         }
         else if (currentState == SET_LIMIT) {
             if (!isTypingCustomAmount) customLimitBtn.update(mPos);
             limitAllBtn.update(mPos);
             if (isTypingCustomAmount) confirmLimitBtn.update(mPos);
+            if (isTypingCustomAmount) {
+                customLimitBtn.shape.setFillColor(Color(40, 40, 40));
+                customLimitBtn.shape.setOutlineColor(Color(180, 200, 255));
+                bool showCursor = (int)(effectClock.getElapsedTime().asSeconds() * 2.0f) % 2 == 0;
+                customInputDisplay.setString(showCursor ? customInputString + "|" : customInputString); // Rebuilt only on a keystroke or cursor blink
+            }
+            else {
+                customLimitBtn.setColor(UI_BASE_COLOR);
+            }
         }
         else if (currentState == PAUSED) {
             startBtn.update(mPos);
@@ -1091,28 +4249,14 @@ int main() {
             pauseBtn.update(mPos);
             quizCamBtn.update(mPos);
         }
-        // Particles
-        for (auto& p : particles) { // Updates position of particles using reference
-            p.shape.move(p.velocity * dt); // Uses speed of particles to easily delete them by checking their timeframes
-            p.lifetime -= dt; // Deletes 0.2s from the 1s lifetime of particles
-            Color c = p.shape.getFillColor(); // Fills the color of Particles
-            c.a = static_cast<uint8_t>(max(0.0f, p.lifetime * 255)); // With time, increase the transparency (255 = solid, 0 = transparent)
-            p.shape.setFillColor(c);
-        }
-        erase_if(particles, [](const Particle& p) { return p.lifetime <= 0; }); // Deletes the particles
+        profiler.lap(PHASE_HOVER);
+        // Particles (moves, fades and deletes expired ones)
+        particles.update(dt);
 
         // FloatingText
-        for (auto& ft : floatTexts) {
-            ft.text.move({ 0, -ft.speed * dt }); // Move Up
-            ft.lifetime -= dt;
-            // Fade out
-            Color c = ft.text.getFillColor();
-            c.a = static_cast<uint8_t>(max(0.0f, (ft.lifetime / 1.0f) * 255));
-            ft.text.setFillColor(c);
-            ft.text.setOutlineColor(Color(0, 0, 0, c.a)); // Fade outline
-        }
-        erase_if(floatTexts, [](const FloatingText& ft) { return ft.lifetime <= 0; }); // Deletes the text
+        floatTexts.update(dt);
 
+        profiler.lap(PHASE_SIMULATION);
         // Quiz Timer
         if (currentState == QUIZ_MODE) {
             if (!isAnswerLocked) {
@@ -1134,7 +4278,7 @@ int main() {
                     if ((int)(timeLeft * 10) % 2 == 0) timerBar.setFillColor(Color(200, 0, 0)); // Make it blink if very low
                     if (timeLeft <= 0) { // If time ends an duser didn't select an option
                         isAnswerLocked = true;
-                        const auto& currentQ = allQuestions[currentQuestionIndex]; // Show the correct answer
+                        QuestionView currentQ = (*bank)[quizOrder[currentQuestionIndex]]; // Show the correct answer
                         options[currentQ.correctAnswerIndex].setColor(CORRECT_COLOR); // Change the correct answer to Green
                         shakeTime = 0.5f; // Shake
                         comboStreak = 0; // Resets Combo Streak
@@ -1161,12 +4305,20 @@ int main() {
             window.setView(originalView); // Resets to normal
         }
 
+        // Results are recorded once per finished quiz, the store saves them in the background
+        if (currentState == GAME_OVER && !scoreRecorded) {
+            scoreRecorded = true;
+            lastRank = scores.record(currentDifficultyName, score, actualTotalQuestions);
+        }
+
         // Fade Logic
         if (fadeAlpha > 0) {
             fadeAlpha -= 500.0f * dt; // Fade speed
             if (fadeAlpha < 0) fadeAlpha = 0;
         }
 
+        profiler.lap(PHASE_TIMERS);
+
         /*-------------------------  Drawing  -------------------------*/
 
         window.clear(BACKGROUND_COLOR);
@@ -1178,241 +4330,105 @@ int main() {
         }
 
         // Particles
-        for (const auto& p : particles) {
-            window.draw(p.shape);
-        }
+        particles.draw(window);
 
         // Floating Text
-        for (const auto& ft : floatTexts) {
-            window.draw(ft.text);
-        }
+        floatTexts.draw(window);
 
         // UI States
-        if (currentState == MENU) {
-            titleText.setString("C++ Logic Builder");
-            titleText.setCharacterSize(55);
-            FloatRect tRect = titleText.getLocalBounds();
-            titleText.setOrigin({ tRect.position.x + tRect.size.x / 2.0f, tRect.position.y + tRect.size.y / 2.0f });
-            titleText.setPosition({ WINDOW_WIDTH / 2.0f, 160.0f });
-            Text shadow = titleText;
-            shadow.setFillColor(Color(0, 0, 0, 150)); // Black with transparency Shadow effect
-            shadow.move({ 4.0f, 4.0f }); // Shift shadow down-right
-            window.draw(shadow);
-            window.draw(titleText);
-
-            Text highScoreText(uifont);
-            highScoreText.setString("High Score: " + to_string(getHighScore()));
-            highScoreText.setCharacterSize(30);
-            highScoreText.setFillColor(Color::Yellow);
-            FloatRect hsRect = highScoreText.getLocalBounds(); // Centering the Text
-            highScoreText.setOrigin({ hsRect.size.x / 2.0f, 0 }); // Origin Setting of the Text
-            highScoreText.setPosition({ WINDOW_WIDTH / 2.0f, 50.0f });
-            shadow = highScoreText;
-            shadow.setFillColor(Color(0, 0, 0, 150));
-            shadow.move({ 4.0f, 4.0f });
-            window.draw(shadow);
-            window.draw(highScoreText);
-
-            Text sub(uifont, "MASTER THE SKILL!", 24);
-            FloatRect sb = sub.getLocalBounds();
-            sub.setOrigin({ sb.size.x / 2, 0 });
-            sub.setPosition({ WINDOW_WIDTH / 2.0f, 220.f });
-            window.draw(sub);
-
-            startBtn.setOptionText("Start Game");
-            startBtn.setPosition({ WINDOW_WIDTH / 2.0f - 120.0f, 300.0f });
-            startBtn.draw(window);
-            settingsBtn.setOptionText("Settings");
-            settingsBtn.setPosition({ WINDOW_WIDTH / 2.0f - 120.0f, 380.0f });
-            settingsBtn.draw(window);
-            exitBtn.setOptionText("Exit Game");
-            exitBtn.setPosition({ WINDOW_WIDTH / 2.0f - 120.0f, 460.0f });
-            exitBtn.draw(window);
-            Text credits(uifont);
-            credits.setString("Created by Muhammad Faizan | End Semester Project");
-            credits.setCharacterSize(18);
-            credits.setFillColor(Color(255, 255, 255, 255)); // White Text
-            FloatRect crRect = credits.getLocalBounds();
-            credits.setOrigin({ crRect.size.x, crRect.size.y }); // Align to bottom-right
-            credits.setPosition({ WINDOW_WIDTH - 20.0f, WINDOW_HEIGHT - 20.0f });
-            window.draw(credits);
-        }
-        else if (currentState == SETTINGS) {
-            titleText.setString("Audio Settings");
-            FloatRect tRect = titleText.getLocalBounds();
-            titleText.setOrigin({ tRect.position.x + tRect.size.x / 2.0f, tRect.position.y + tRect.size.y / 2.0f });
-            titleText.setPosition({ WINDOW_WIDTH / 2.0f, 160.0f });
-            Text shadow = titleText;
-            shadow.setFillColor(Color(0, 0, 0, 150));
-            shadow.move({ 4.0f, 4.0f });
-            window.draw(shadow);
-            window.draw(titleText);
-            // Drawing all Buttons in Settings
-            toggleMusicBtn.draw(window);
-            toggleSfxBtn.draw(window);
-            toggleCamBtn.draw(window);
-            volDownBtn.draw(window);
-            window.draw(volumeDisplay);
-            volUpBtn.draw(window);
-            backSettingsBtn.draw(window);
-        }
-        else if (currentState == SELECT_DIFFICULTY) {
-            titleText.setString("Select Difficulty");
-            FloatRect tRect = titleText.getLocalBounds();
-            titleText.setOrigin({ tRect.position.x + tRect.size.x / 2.0f, tRect.position.y + tRect.size.y / 2.0f });
-            titleText.setPosition({ WINDOW_WIDTH / 2.0f, 160.0f });
-            Text shadow = titleText;
-            shadow.setFillColor(Color(0, 0, 0, 150)); // Black shadow
-            shadow.move({ 4.0f, 4.0f });
-            window.draw(shadow);
-            window.draw(titleText);
-            easyBtn.draw(window);
-            mediumBtn.draw(window);
-            hardBtn.draw(window);
+        if (currentState != uiState) {
+            uiState = currentState;
+            layoutUiState();
+            if (currentState != SELECT_DIFFICULTY) pendingDifficulty = -1; // A waiting pick only counts on the screen it was made on
         }
-        else if (currentState == SET_LIMIT) {
-            titleText.setString(currentDifficultyName);
-            titleText.setPosition({ WINDOW_WIDTH / 2.0f, 150.0f });
-            titleText.setCharacterSize(55); // Make it slightly larger
-            titleText.setFillColor(Color(180, 200, 255)); // Light Blue tint
-
-            // Perfect Centering
-            FloatRect tr = titleText.getLocalBounds();
-            titleText.setOrigin({ tr.position.x + tr.size.x / 2.0f, tr.position.y + tr.size.y / 2.0f });
-            titleText.setPosition({ WINDOW_WIDTH / 2.0f, 150.0f });
-
-            // Shadow Effect
-            Text titleShadow = titleText;
-            titleShadow.setFillColor(Color(0, 0, 0, 180)); // Dark semi-transparent black
-            titleShadow.move({ 5.0f, 5.0f }); // Shift 5 pixels down and right
-
-            window.draw(titleShadow); // Draw shadow Behind the text
-            window.draw(titleText);
-
-            Text prompt(uifont);
-            prompt.setString("Questions Available: " + to_string(totalQuestions));
-            prompt.setCharacterSize(24);
-            prompt.setFillColor(Color::White);
-            FloatRect pr = prompt.getLocalBounds();
-            prompt.setOrigin({ pr.size.x / 2, 0 });
-            prompt.setPosition({ WINDOW_WIDTH / 2.0f, 230.0f });
-            window.draw(prompt);
-
-            if (isTypingCustomAmount) {
-                customLimitBtn.shape.setFillColor(Color(40, 40, 40));
-                customLimitBtn.shape.setOutlineColor(Color(180, 200, 255));
-                window.draw(customLimitBtn.shape);
-                bool showCursor = (int)(effectClock.getElapsedTime().asSeconds() * 2.0f) % 2 == 0;
-                if (showCursor) {
-                    customInputDisplay.setString(customInputString + "|");
-                }
-                else {
-                    customInputDisplay.setString(customInputString);
-                }
-                customInputDisplay.setFillColor(Color(180, 200, 255));
-                customInputDisplay.setCharacterSize(30);
-                FloatRect bounds = customInputDisplay.getLocalBounds();
-                Vector2f btnCenter = customLimitBtn.shape.getPosition() + (customLimitBtn.shape.getSize() / 2.0f);
-                customInputDisplay.setOrigin({ bounds.position.x + bounds.size.x / 2.0f, bounds.position.y + bounds.size.y / 2.0f });
-                customInputDisplay.setPosition(btnCenter);
-                window.draw(customInputDisplay);
-
-                Text sub(uifont, "Type amount & Press ENTER", 18);
-                sub.setFillColor(Color::Yellow);
-                FloatRect subRect = sub.getLocalBounds();
-                sub.setOrigin({ subRect.position.x + subRect.size.x / 2.0f, 0.f });
-                sub.setPosition({ btnCenter.x, btnCenter.y + 45 });
-                window.draw(sub);
-                confirmLimitBtn.draw(window);
-            }
-            else {
-                customLimitBtn.setColor(UI_BASE_COLOR);
-                customLimitBtn.draw(window);
-            }
-            limitAllBtn.draw(window);
-        }
-        else if (currentState == QUIZ_MODE || currentState == PAUSED) {
-            titleText.setString(currentDifficultyName);
-            titleText.setPosition({ WINDOW_WIDTH / 2.0f, 60.0f });
-            FloatRect b = titleText.getLocalBounds();
-            titleText.setOrigin({ b.position.x + b.size.x / 2.0f, 0.0f });
-            // Draw Shadow
-            Text tShadow = titleText;
-            tShadow.setFillColor(Color(0, 0, 0, 150)); // Transparent Black
-            tShadow.move({ 3.0f, 3.0f });              // Shift 3 pixels down-right
-            window.draw(tShadow);
+        if (currentState == QUIZ_MODE || currentState == PAUSED) {
             window.draw(titleText);
             window.draw(timerTrack);
             window.draw(timerBar);
             window.draw(questionText);
             for (int i = 0; i < 4; ++i) options[i].draw(window);
-            scoreText.setString("Question: " + to_string(currentQuestionIndex + 1) + "/" + to_string(actualTotalQuestions) + " | Score: " + to_string(score));
+            if (!scoreTextBuilt || score != shownScore || currentQuestionIndex != shownQuestion) {
+                scoreTextBuilt = true;
+                shownScore = score;
+                shownQuestion = currentQuestionIndex;
+                scoreText.setString("Question: " + to_string(currentQuestionIndex + 1) + "/" + to_string(actualTotalQuestions) + " | Score: " + to_string(score));
+            }
             window.draw(scoreText);
             skipBtn.draw(window);
             backBtn.draw(window);
             pauseBtn.draw(window);
             quizCamBtn.draw(window);
+            if (cameraEnabled && previewAvailable && gestureTracker.updatePreview(previewTexture)) {
+                const GestureState& gesture = gestureTracker.latestState();
+                bool holding = gesture.stableCount > 0;
+                previewFrame.setOutlineColor(holding ? Color(255, 255, 0) : Color(200, 50, 50)); // Yellow = holding, Red = detecting
+                previewHoldBar.setSize({ PREVIEW_SIZE * gesture.holdProgress, 6.f });
+                if (gesture.calibrating) previewLabel.setString("Calibrating...");
+                else previewLabel.setString(holding ? "Hold: " + to_string(gesture.stableCount) : "Detecting...");
+                window.draw(previewSprite);
+                window.draw(previewFrame);
+                window.draw(previewHoldBar);
+                window.draw(previewLabel);
+            }
 
             if (currentState == PAUSED) {
-                RectangleShape overlay({ WINDOW_WIDTH, WINDOW_HEIGHT });
-                overlay.setFillColor(Color(0, 0, 0, 200));
-                window.draw(overlay);
-                Text pauseTitle(uifont, "PAUSED", 60);
-                pauseTitle.setFillColor(Color::White);
-                FloatRect ptRect = pauseTitle.getLocalBounds();
-                pauseTitle.setOrigin({ ptRect.position.x + ptRect.size.x / 2.0f, 0 });
-                pauseTitle.setPosition({ WINDOW_WIDTH / 2.0f, 150.0f });
+                window.draw(pauseOverlay);
                 window.draw(pauseTitle);
-
-                startBtn.setOptionText("Resume Game (Esc)");
-                startBtn.setPosition({ WINDOW_WIDTH / 2.0f - 120.0f, 300.0f });
                 startBtn.draw(window);
-                endQuizBtn.setPosition({ WINDOW_WIDTH / 2.0f - 120.0f, 380.0f });
                 endQuizBtn.draw(window);
-                exitBtn.setOptionText("Exit to Main Menu");
-                exitBtn.setPosition({ WINDOW_WIDTH / 2.0f - 120.0f, 460.0f });
                 exitBtn.draw(window);
             }
         }
-        else if (currentState == GAME_OVER) {
-            saveHighScore(score);
-            titleText.setString("QUIZ COMPLETE!");
-            titleText.setCharacterSize(60);
-            FloatRect tRect = titleText.getLocalBounds();
-            titleText.setOrigin({ tRect.position.x + tRect.size.x / 2.0f, tRect.position.y + tRect.size.y / 2.0f });
-            titleText.setPosition({ WINDOW_WIDTH / 2.0f, 150.0f });
-            Text tShadow = titleText;
-            tShadow.setFillColor(Color(0, 0, 0, 150));
-            tShadow.move({ 4.0f, 4.0f });
-            window.draw(tShadow);
-            window.draw(titleText);
-
-            string finalScoreString = "Final score: " + to_string(score) + " / " + to_string(actualTotalQuestions);
-            Text finalScore(uifont, finalScoreString, 40);
-            FloatRect fsRect = finalScore.getLocalBounds();
-            finalScore.setOrigin({ fsRect.position.x + fsRect.size.x / 2.0f, 0 });
-            finalScore.setPosition({ WINDOW_WIDTH / 2.0f, 230.0f });
-            window.draw(finalScore);
-
-            startBtn.setOptionText("Back to Menu");
-            startBtn.setPosition({ WINDOW_WIDTH / 2.0f - 120.0f, 300.0f });
-            startBtn.draw(window);
-            exitBtn.setOptionText("Exit Game");
-            exitBtn.setPosition({ WINDOW_WIDTH / 2.0f - 120.0f, 380.0f });
-            exitBtn.draw(window);
+        else {
+            if (screenLayer.isAvailable()) {
+                // Everything the static screens show, a change in any of it redraws the layer
+                uint64_t signature = foldHash((uint64_t)currentState, (uint64_t)isTypingCustomAmount);
+                for (const UiLabel* label : { &titleText, &highScoreText, &menuSubtitle, &credits, &limitPrompt, &limitHint, &finalScore, &rankText, &volumeDisplay, &customInputDisplay })
+                    signature = foldHash(signature, label->signature());
+                for (const OptionButton* button : { &startBtn, &settingsBtn, &exitBtn, &toggleMusicBtn, &toggleSfxBtn, &toggleCamBtn, &volDownBtn, &volUpBtn, &backSettingsBtn,
+                                                    &easyBtn, &mediumBtn, &hardBtn, &customLimitBtn, &confirmLimitBtn, &limitAllBtn })
+                    signature = foldHash(signature, button->signature());
+                if (screenLayer.needsRedraw(signature)) {
+                    drawStaticScreen(screenLayer.target());
+                    screenLayer.finish();
+                }
+                screenLayer.draw(window);
+            }
+            else {
+                drawStaticScreen(window);
+            }
         }
         // Draw Fade Overlay
         if (fadeAlpha > 0) {
             fadeRect.setFillColor(Color(0, 0, 0, static_cast<uint8_t>(fadeAlpha)));
             window.draw(fadeRect);
         }
+        profiler.lap(PHASE_DRAW);
+        if (profiler.overlayVisible) {
+            window.setView(originalView); // Overlay does not shake
+            profiler.drawOverlay(window);
+        }
+        profiler.lap(PHASE_OVERLAY);
         window.display();
+        if (gestureFeedbackPending) gestureTracker.recordFeedbackShown();
+        profiler.lap(PHASE_DISPLAY);
+        profiler.endFrame();
+
+        // Quiz (timer bar, camera) and anything still fading, shaking or flying keeps the full frame rate
+        bool animating = currentState == QUIZ_MODE || fadeAlpha > 0 || shakeTime > 0 || particles.size() > 0 || floatTexts.size() > 0
+            || (currentState == SELECT_DIFFICULTY && pendingDifficulty >= 0); // Polls until the picked bank finishes loading
+        governor.endFrame(dt, animating || hadInput);
     }
+    gestureTracker.latency.print(cout);
+    governor.print(cout);
+    if (screenLayer.isAvailable()) cout << "Screen layer redraws: " << screenLayer.redrawCount() << endl;
+    profiler.printSummary(cout);
+    if (!profiler.writeCsv(profileCsvPath)) cerr << "Warning: Could not write " << profileCsvPath << "." << endl;
     return 0;
 }
 
 OptionButton::OptionButton(float x, float y, float w, float h, const string& prefixText, const Font& font)
-    : text(font), prefix(font)
+    : text(font, "", 20, Color::White), prefix(font, "", 28, Color::Yellow)
 {
     originalPos = { x, y };
     shape.setPosition({ x, y });
@@ -1420,13 +4436,11 @@ OptionButton::OptionButton(float x, float y, float w, float h, const string& pre
     shape.setCornersRadius(15.0f);
     shape.setFillColor(baseFillColor);
     shape.setOutlineThickness(0);
+    text.setShadow(Color(0, 0, 0, 150), { 3.0f, 3.0f });
+    prefix.setShadow(Color(0, 0, 0, 150), { 3.0f, 3.0f });
     prefix.setString(prefixText);
-    prefix.setCharacterSize(28);
-    prefix.setFillColor(Color::Yellow);
     float textVerticalOffset = (h / 2.0f) - (prefix.getCharacterSize() / 2.0f) - 5;
     prefix.setPosition({ x + 15, y + textVerticalOffset });
-    text.setCharacterSize(20);
-    text.setFillColor(Color::White);
     if (prefixText != "A:" && prefixText != "B:" && prefixText != "C:" && prefixText != "D:") { setOptionText(prefixText); }
 }
 void OptionButton::update(Vector2i mousePos) {
@@ -1456,26 +4470,29 @@ void OptionButton::update(Vector2i mousePos) {
         shape.setOutlineThickness(0);
     }
 }
-void OptionButton::setOptionText(const string& optionText) {
-    text.setString(optionText); FloatRect textBounds = text.getLocalBounds();
+void OptionButton::setOptionText(string_view optionText) {
+    text.setString(optionText); // Only relays out the glyphs when the string changed
+    placeText();
+}
+void OptionButton::placeText() {
     float buttonWidth = shape.getSize().x; float buttonHeight = shape.getSize().y; float shapeX = shape.getPosition().x; float shapeY = shape.getPosition().y;
-    float newX = prefix.getString().isEmpty() ? shapeX + (buttonWidth / 2.0f) - (textBounds.size.x / 2.0f) : shapeX + 70;
+    text.setAlignment({ prefix.getString().empty() ? 0.5f : 0.f, 0.f }); // Centered unless there is a prefix
+    float newX = prefix.getString().empty() ? shapeX + (buttonWidth / 2.0f) : shapeX + 70;
     float newY = shapeY + (buttonHeight / 2.0f) - (text.getCharacterSize() / 2.0f) - 5;
     text.setPosition({ newX, newY });
 }
-void OptionButton::draw(RenderWindow& window) const {
+void OptionButton::draw(RenderTarget& window) const {
     window.draw(shape);
-    Text tShadow = text; tShadow.setFillColor(Color(0, 0, 0, 150)); tShadow.move({ 3.0f, 3.0f }); window.draw(tShadow);
-    if (!prefix.getString().isEmpty()) { Text pShadow = prefix; pShadow.setFillColor(Color(0, 0, 0, 150)); pShadow.move({ 3.0f, 3.0f }); window.draw(pShadow); }
-    window.draw(prefix); window.draw(text);
+    window.draw(prefix); window.draw(text); // Shadows are baked into the labels
 }
 void OptionButton::setPosition(const Vector2f& pos) {
+    if (pos == originalPos && pos == shape.getPosition()) return; // Hover reset calls this every frame
     shape.setPosition(pos);
     originalPos = pos;
     prefix.setPosition({ pos.x + 15, pos.y + (shape.getSize().y / 2.0f) - (prefix.getCharacterSize() / 2.0f) - 5 });
-    setOptionText(text.getString());
+    placeText();
 }
-// Load Function
+// Original line-by-line loader, kept as the baseline for --bench-parser (the game uses QuestionTextParser)
 vector<QuizQuestion> loadQuestionsFromFile(const string& filename) {
     vector<QuizQuestion> questions;
     ifstream file(filename);
@@ -1506,34 +4523,859 @@ vector<QuizQuestion> loadQuestionsFromFile(const string& filename) {
     }
     return questions;
 }
-void spawnParticles(vector<Particle>& particles, Vector2f pos, Color color) {
-    for (int i = 0; i < 20; i++) { // Spawn 20 particles
-        Particle p;
-        p.shape.setSize({ 8.f, 8.f });
-        p.shape.setPosition(pos);
-        p.shape.setFillColor(color);
-        p.lifetime = 1.0f; // Lasts 1 second
+// --compile-bank <bank.txt> [out.qbk]: turns a text bank into the memory-mapped format the game prefers
+int runBankCompiler(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "Usage: --compile-bank <bank.txt> [out.qbk]" << endl;
+        return 1;
+    }
+    string input = argv[2];
+    string output = argc > 3 ? argv[3] : filesystem::path(input).replace_extension(".qbk").string();
+    QuestionBank source;
+    if (!source.loadText(input)) {
+        cerr << "Error: No questions found in " << input << "." << endl;
+        return 1;
+    }
+    vector<char> compiled = QuestionBank::compile(source);
+    if (compiled.empty()) {
+        cerr << "Error: " << input << " has more than 4 GB of text, which does not fit the bank format." << endl;
+        return 1;
+    }
+    ofstream out(output, ios::binary | ios::trunc);
+    if (!out.write(compiled.data(), (streamsize)compiled.size()) || !out.flush()) {
+        cerr << "Error: Could not write " << output << "." << endl;
+        return 1;
+    }
+    out.close();
+    QuestionBank check; // Read it back the way the game will
+    if (!check.openCompiled(output) || check.size() != source.size()) {
+        cerr << "Error: " << output << " did not read back correctly." << endl;
+        return 1;
+    }
+    cout << "Compiled " << source.size() << " questions from " << input << " to " << output << " (" << compiled.size() << " bytes, version " << QuestionBank::VERSION << ")" << endl;
+    return 0;
+}
 
+void spawnParticles(ParticlePool& particles, Vector2f pos, Color color) {
+    for (int i = 0; i < 20; i++) { // Spawn 20 particles
         // Random velocity
         float angle = (rand() % 360) * 3.14159f / 180.f;
         float speed = (rand() % 150 + 50); // Speed between 50 and 200
-        p.velocity = { cos(angle) * speed, sin(angle) * speed };
+        particles.spawn(pos, { cos(angle) * speed, sin(angle) * speed }, 1.0f, color); // Lasts 1 second
+    }
+}
+
+// Min/median/p99/mean of a set of samples (milliseconds)
+struct SampleStats {
+    double min = 0, median = 0, p99 = 0, mean = 0;
+};
+
+SampleStats computeStats(vector<double> samples) {
+    SampleStats stats;
+    if (samples.empty()) return stats;
+    sort(samples.begin(), samples.end());
+    stats.min = samples.front();
+    stats.median = samples[samples.size() / 2];
+    stats.p99 = samples[min(samples.size() - 1, (size_t)ceil(samples.size() * 0.99) - 1)];
+    double sum = 0;
+    for (double v : samples) sum += v;
+    stats.mean = sum / samples.size();
+    return stats;
+}
+
+string statsToJson(const SampleStats& s) {
+    ostringstream out;
+    out.setf(ios::fixed);
+    out.precision(4);
+    out << "{ \"min_ms\": " << s.min << ", \"median_ms\": " << s.median << ", \"p99_ms\": " << s.p99 << ", \"mean_ms\": " << s.mean << " }";
+    return out.str();
+}
+
+// Text bank with lines shaped like the real ones: escaped newlines, repeated options, a comment now and then
+bool writeSyntheticBank(const string& path, int lines) {
+    ofstream file(path, ios::binary | ios::trunc);
+    mt19937 rng(1234);
+    for (int i = 0; i < lines; i++) {
+        if (i % 1000 == 0) {
+            file << "# Question|A|B|C|D|CorrectIndex\n";
+            continue;
+        }
+        int a = rng() % 100, b = rng() % 100;
+        file << "What is the output?\\n\\nint a = " << a << ";\\nint b = " << b << ";\\ncout << a + b;|"
+             << a + b << "|" << a - b << "|Error|" << a * b << "|" << rng() % 4 << "\n";
+    }
+    return (bool)file;
+}
+
+// Usage: --bench-parser [--lines N] [--repeat R] [--threads T] [--out file.json]
+// Writes a synthetic bank, then times the original loader against QuestionTextParser on one and on T threads
+// (file reading included for both) and checks that they produce the same questions
+int runParserBenchmark(int argc, char* argv[]) {
+    int lines = 1000000;
+    int repeat = 3;
+    unsigned threads = max(1u, thread::hardware_concurrency());
+    string outPath;
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--lines" && i + 1 < argc) lines = max(1, atoi(argv[++i]));
+        else if (arg == "--repeat" && i + 1 < argc) repeat = max(1, atoi(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) threads = (unsigned)max(1, atoi(argv[++i]));
+        else if (arg == "--out" && i + 1 < argc) outPath = argv[++i];
+    }
+
+    string path = (filesystem::temp_directory_path() / "bench_questions.txt").string();
+    if (!writeSyntheticBank(path, lines)) {
+        cerr << "Error: Could not write " << path << "." << endl;
+        return 1;
+    }
+    uintmax_t bytes = filesystem::file_size(path);
+
+    auto timeMs = [](auto&& run) {
+        auto start = chrono::steady_clock::now();
+        run();
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    };
+    vector<double> legacyTimes, singleTimes, threadedTimes;
+    vector<QuizQuestion> legacy;
+    QuestionBank single, threaded;
+    for (int r = 0; r < repeat; r++) {
+        legacyTimes.push_back(timeMs([&] { legacy = loadQuestionsFromFile(path); }));
+        singleTimes.push_back(timeMs([&] { single.loadText(path, 1); }));
+        threadedTimes.push_back(timeMs([&] { threaded.loadText(path, threads); }));
+    }
+    filesystem::remove(path);
+
+    bool identical = legacy.size() == single.size() && legacy.size() == threaded.size();
+    for (size_t i = 0; identical && i < legacy.size(); i++) {
+        QuestionView a = single[i], b = threaded[i];
+        identical = a.text == legacy[i].questionText && b.text == a.text && a.correctAnswerIndex == legacy[i].correctAnswerIndex && b.correctAnswerIndex == a.correctAnswerIndex;
+        for (int k = 0; identical && k < 4; k++) identical = a.options[k] == legacy[i].options[k] && b.options[k] == a.options[k];
+    }
+
+    SampleStats legacyStats = computeStats(legacyTimes), singleStats = computeStats(singleTimes), threadedStats = computeStats(threadedTimes);
+    ostringstream json;
+    json.setf(ios::fixed);
+    json.precision(2);
+    json << "{\n";
+    json << "  \"lines\": " << lines << ",\n";
+    json << "  \"bytes\": " << bytes << ",\n";
+    json << "  \"questions\": " << legacy.size() << ",\n";
+    json << "  \"repeat\": " << repeat << ",\n";
+    json << "  \"threads\": " << threads << ",\n";
+    json << "  \"legacy\": " << statsToJson(legacyStats) << ",\n";
+    json << "  \"parser_1_thread\": " << statsToJson(singleStats) << ",\n";
+    json << "  \"parser_threads\": " << statsToJson(threadedStats) << ",\n";
+    json << "  \"speedup_1_thread\": " << legacyStats.median / max(singleStats.median, 1e-9) << ",\n";
+    json << "  \"speedup_threads\": " << legacyStats.median / max(threadedStats.median, 1e-9) << ",\n";
+    json << "  \"identical\": " << (identical ? "true" : "false") << "\n";
+    json << "}\n";
+    cout << json.str();
+    if (!outPath.empty()) {
+        ofstream out(outPath);
+        out << json.str();
+    }
+    if (!identical) cerr << "Error: The parser and the original loader disagree." << endl;
+    return identical ? 0 : 1;
+}
+
+// Usage: --bench-store [bank.txt] [--lines N] [--repeat R] [--out file.json]
+// Loads a text bank (a synthetic one of N lines by default) as the original vector<QuizQuestion>, as a parsed
+// QuestionBank and as the resident QuestionStore, and opens it compiled to .qbk. Reports load time and bytes per
+// question for each (heap bytes, or the mapped file for the compiled bank)
+int runStoreBenchmark(int argc, char* argv[]) {
+    string input;
+    int lines = 1000000;
+    int repeat = 3;
+    string outPath;
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--lines" && i + 1 < argc) lines = max(1, atoi(argv[++i]));
+        else if (arg == "--repeat" && i + 1 < argc) repeat = max(1, atoi(argv[++i]));
+        else if (arg == "--out" && i + 1 < argc) outPath = argv[++i];
+        else input = arg;
+    }
+    string path = input.empty() ? (filesystem::temp_directory_path() / "bench_store.txt").string() : input;
+    if (input.empty() && !writeSyntheticBank(path, lines)) {
+        cerr << "Error: Could not write " << path << "." << endl;
+        return 1;
+    }
+
+    auto timeMs = [](auto&& run) {
+        auto start = chrono::steady_clock::now();
+        run();
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    };
+    vector<double> legacyTimes, bankTimes, storeTimes;
+    vector<QuizQuestion> legacy;
+    QuestionBank bank;
+    QuestionStore store;
+    for (int r = 0; r < repeat; r++) {
+        legacyTimes.push_back(timeMs([&] { legacy = loadQuestionsFromFile(path); }));
+        bankTimes.push_back(timeMs([&] { bank.loadText(path); }));
+        storeTimes.push_back(timeMs([&] {
+            QuestionBank source;
+            source.loadText(path);
+            store.build(source);
+            }));
+    }
+    if (input.empty()) filesystem::remove(path);
+    if (legacy.empty()) {
+        cerr << "Error: No questions in " << path << "." << endl;
+        return 1;
+    }
+
+    string compiledPath = (filesystem::temp_directory_path() / "bench_store.qbk").string();
+    vector<char> compiledBytes = QuestionBank::compile(bank);
+    {
+        ofstream out(compiledPath, ios::binary | ios::trunc);
+        out.write(compiledBytes.data(), (streamsize)compiledBytes.size());
+    }
+    vector<double> compiledTimes;
+    size_t compiledMemory = 0;
+    bool identical = store.size() == legacy.size();
+    {
+        QuestionBank compiled; // Unmapped at the end of the block, before the file is removed
+        for (int r = 0; r < repeat; r++) compiledTimes.push_back(timeMs([&] { compiled.openCompiled(compiledPath); }));
+        compiledMemory = compiled.memoryBytes();
+        identical = identical && compiled.size() == legacy.size();
+        for (size_t i = 0; identical && i < legacy.size(); i++) {
+            QuestionView q = store[i], c = compiled[i];
+            identical = q.text == legacy[i].questionText && c.text == q.text && q.correctAnswerIndex == legacy[i].correctAnswerIndex && c.correctAnswerIndex == q.correctAnswerIndex;
+            for (int k = 0; identical && k < 4; k++) identical = q.options[k] == legacy[i].options[k] && c.options[k] == q.options[k];
+        }
+    }
+    filesystem::remove(compiledPath);
+
+    // Heap bytes of the original layout, allocator overhead not counted (short strings live inside the object)
+    auto stringHeap = [](const string& s) { return s.capacity() > string().capacity() ? s.capacity() + 1 : (size_t)0; };
+    size_t legacyBytes = legacy.capacity() * sizeof(QuizQuestion);
+    for (const QuizQuestion& q : legacy) {
+        legacyBytes += stringHeap(q.questionText) + q.options.capacity() * sizeof(string);
+        for (const string& option : q.options) legacyBytes += stringHeap(option);
+    }
+
+    double questions = (double)legacy.size();
+    auto layoutJson = [&](const vector<double>& times, size_t bytes) {
+        ostringstream out;
+        out.setf(ios::fixed);
+        out.precision(2);
+        out << "{ \"load\": " << statsToJson(computeStats(times)) << ", \"bytes\": " << bytes << ", \"bytes_per_question\": " << bytes / questions << " }";
+        return out.str();
+    };
+    ostringstream json;
+    json.setf(ios::fixed);
+    json.precision(2);
+    json << "{\n";
+    json << "  \"file\": \"" << (input.empty() ? "synthetic" : input) << "\",\n";
+    json << "  \"questions\": " << legacy.size() << ",\n";
+    json << "  \"distinct_strings\": " << store.stringCount() << ",\n";
+    json << "  \"repeat\": " << repeat << ",\n";
+    json << "  \"vector_quiz_question\": " << layoutJson(legacyTimes, legacyBytes) << ",\n";
+    json << "  \"question_bank\": " << layoutJson(bankTimes, bank.memoryBytes()) << ",\n";
+    json << "  \"question_store\": " << layoutJson(storeTimes, store.memoryBytes()) << ",\n";
+    json << "  \"compiled_bank\": " << layoutJson(compiledTimes, compiledMemory) << ",\n";
+    json << "  \"identical\": " << (identical ? "true" : "false") << "\n";
+    json << "}\n";
+    cout << json.str();
+    if (!outPath.empty()) {
+        ofstream out(outPath);
+        out << json.str();
+    }
+    if (!identical) cerr << "Error: The question store or the compiled bank disagrees with the original loader." << endl;
+    return identical ? 0 : 1;
+}
+
+// Headless per-stage benchmark of the finger counting pipeline, prints JSON
+// Usage: --bench-gesture [source spec] [--frames N] [--repeat R] [--track] [--scale 1|2|4] [--out file.json]
+int runGestureBenchmark(int argc, char* argv[]) {
+    string spec = "synthetic";
+    int maxFrames = 300;
+    int repeat = 5;
+    bool tracking = false;
+    int scale = 1;
+    string outPath;
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--track") tracking = true;
+        else if (arg == "--scale" && i + 1 < argc) scale = atoi(argv[++i]);
+        else if (arg == "--frames" && i + 1 < argc) maxFrames = max(1, atoi(argv[++i]));
+        else if (arg == "--repeat" && i + 1 < argc) repeat = max(1, atoi(argv[++i]));
+        else if (arg == "--out" && i + 1 < argc) outPath = argv[++i];
+        else spec = arg;
+    }
+
+    installAllocationCounter();
+    auto source = makeFrameSource(spec, FramePacing::AsFastAsPossible);
+    if (!source || !source->open()) {
+        cerr << "Error: Could not open frame source '" << spec << "'." << endl;
+        return 1;
+    }
+    // Load the corpus up front so decoding and disk time are not measured
+    vector<Mat> corpus;
+    vector<int> labels; // Ground truth finger counts, -1 when the source has none
+    TimedFrame timed;
+    while ((int)corpus.size() < maxFrames && source->read(timed)) {
+        corpus.push_back(timed.image.clone());
+        labels.push_back(timed.label);
+    }
+    source->close();
+    if (corpus.empty()) {
+        cerr << "Error: Frame source '" << spec << "' produced no frames." << endl;
+        return 1;
+    }
+
+    GesturePipeline pipeline;
+    pipeline.tracking = tracking;
+    pipeline.setScale(scale);
+    for (const Mat& f : corpus) pipeline.process(f); // Warm-up pass, not recorded
+
+    vector<double> stageTimes[STAGE_COUNT];
+    vector<double> frameTimes;
+    for (auto& times : stageTimes) times.reserve(corpus.size() * repeat);
+    frameTimes.reserve(corpus.size() * repeat);
+    uint64_t steadyAllocations = 0;
+    uint64_t maxFrameAllocations = 0;
+    double roiPixels = 0; // Processed pixels summed over all frames, shrinks with tracking
+    for (int r = 0; r < repeat; r++) {
+        for (const Mat& f : corpus) {
+            uint64_t allocationsBefore = processAllocations(); // All threads, so OpenCV's workers count too
+            pipeline.begin(f);
+            double frameMs = 0;
+            for (int stage = 0; stage < STAGE_COUNT; stage++) {
+                auto t0 = chrono::steady_clock::now();
+                pipeline.runStage((GestureStage)stage);
+                double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+                stageTimes[stage].push_back(ms);
+                frameMs += ms;
+            }
+            uint64_t frameAllocations = processAllocations() - allocationsBefore; // Timing vectors are reserved, so this is all pipeline
+            steadyAllocations += frameAllocations;
+            maxFrameAllocations = max(maxFrameAllocations, frameAllocations);
+            frameTimes.push_back(frameMs);
+            roiPixels += pipeline.roiRect.area();
+        }
+    }
+
+    // Segmentation head to head: fused kernel vs cvtColor + inRange on the same ROIs
+    vector<double> fusedTimes, referenceTimes;
+    Mat hsv, mask;
+    for (int r = 0; r < repeat; r++) {
+        for (const Mat& f : corpus) {
+            Mat roi = f(pipeline.searchRectIn(f));
+            auto t0 = chrono::steady_clock::now();
+            segmentSkin(roi, mask);
+            auto t1 = chrono::steady_clock::now();
+            segmentSkinReference(roi, hsv, mask);
+            auto t2 = chrono::steady_clock::now();
+            fusedTimes.push_back(chrono::duration<double, milli>(t1 - t0).count());
+            referenceTimes.push_back(chrono::duration<double, milli>(t2 - t1).count());
+        }
+    }
+    SampleStats fusedStats = computeStats(fusedTimes);
+    SampleStats referenceStats = computeStats(referenceTimes);
+
+    // Calibrated color table on the same ROIs, trained on the corpus with the fixed rule's mask as ground truth
+    SkinColorTable table;
+    BitMask skinBits, backgroundBits;
+    for (const Mat& f : corpus) {
+        Mat roi = f(pipeline.searchRectIn(f));
+        segmentSkinPacked(roi, skinBits);
+        invertMask(skinBits, backgroundBits);
+        table.addSamples(roi, skinBits, backgroundBits);
+    }
+    table.rebuild();
+    vector<double> tableTimes;
+    for (int r = 0; r < repeat; r++) {
+        for (const Mat& f : corpus) {
+            Mat roi = f(pipeline.searchRectIn(f));
+            auto t0 = chrono::steady_clock::now();
+            segmentSkinTable(roi, skinBits, table);
+            tableTimes.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count());
+        }
+    }
+    SampleStats tableStats = computeStats(tableTimes);
+
+    // Cleanup head to head: bit-packed (segment + morphology + unpack) vs segment + erode/dilate/GaussianBlur
+    vector<double> packedTimes, opencvTimes;
+    BitMask bits;
+    BinaryMorphology morphology;
+    for (int r = 0; r < repeat; r++) {
+        for (const Mat& f : corpus) {
+            Mat roi = f(pipeline.searchRectIn(f));
+            auto t0 = chrono::steady_clock::now();
+            cleanMaskPacked(roi, bits, morphology, mask);
+            auto t1 = chrono::steady_clock::now();
+            segmentSkin(roi, mask);
+            cleanMaskReference(mask);
+            auto t2 = chrono::steady_clock::now();
+            packedTimes.push_back(chrono::duration<double, milli>(t1 - t0).count());
+            opencvTimes.push_back(chrono::duration<double, milli>(t2 - t1).count());
+        }
+    }
+    SampleStats packedStats = computeStats(packedTimes);
+    SampleStats opencvStats = computeStats(opencvTimes);
+
+    // Hand extraction head to head, both starting from the cleaned mask:
+    // run labelling + border trace + integer classifier vs findContours(RETR_TREE) + contourArea + copy + acos
+    vector<double> extractorTimes, findContoursTimes;
+    GesturePipeline extraction;
+    for (int r = 0; r < repeat; r++) {
+        for (const Mat& f : corpus) {
+            cleanMaskPacked(f(pipeline.searchRectIn(f)), extraction.bits, morphology, mask);
+            auto t0 = chrono::steady_clock::now();
+            for (int stage = STAGE_EXTRACT; stage < STAGE_COUNT; stage++) extraction.runStage((GestureStage)stage);
+            auto t1 = chrono::steady_clock::now();
+            countFingersReference(mask);
+            auto t2 = chrono::steady_clock::now();
+            extractorTimes.push_back(chrono::duration<double, milli>(t1 - t0).count());
+            findContoursTimes.push_back(chrono::duration<double, milli>(t2 - t1).count());
+        }
+    }
+    SampleStats extractorStats = computeStats(extractorTimes);
+    SampleStats findContoursStats = computeStats(findContoursTimes);
+
+    // Accuracy vs speed for every processing scale: accuracy against the source's labels (if it has any),
+    // agreement against scale 1 (always available, also for unlabelled recordings)
+    const int SCALES[] = { 1, 2, 4 };
+    vector<int> fullScaleCounts;
+    ostringstream scalesJson;
+    scalesJson.setf(ios::fixed);
+    scalesJson.precision(4);
+    for (int scaleIndex = 0; scaleIndex < 3; scaleIndex++) {
+        GesturePipeline scaled;
+        scaled.tracking = tracking;
+        scaled.setScale(SCALES[scaleIndex]);
+        for (const Mat& f : corpus) scaled.process(f); // Warm-up
+        vector<double> times;
+        vector<int> counts;
+        times.reserve(corpus.size() * repeat);
+        int handsFound = 0; // In the last repeat
+        for (int r = 0; r < repeat; r++) {
+            counts.clear();
+            handsFound = 0;
+            for (const Mat& f : corpus) {
+                auto t0 = chrono::steady_clock::now();
+                counts.push_back(scaled.process(f));
+                times.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count());
+                if (scaled.handFound) handsFound++;
+            }
+        }
+        if (scaleIndex == 0) fullScaleCounts = counts;
+        int labelled = 0, correct = 0, agree = 0;
+        for (size_t i = 0; i < counts.size(); i++) {
+            if (labels[i] >= 0) {
+                labelled++;
+                if (counts[i] == labels[i]) correct++;
+            }
+            if (counts[i] == fullScaleCounts[i]) agree++;
+        }
+        SampleStats stats = computeStats(times);
+        scalesJson << "    { \"scale\": " << SCALES[scaleIndex] << ", \"frame\": " << statsToJson(stats);
+        scalesJson << ", \"fps\": " << (stats.mean > 0 ? 1000.0 / stats.mean : 0.0);
+        if (labelled > 0) scalesJson << ", \"accuracy\": " << (double)correct / labelled;
+        else scalesJson << ", \"accuracy\": null";
+        scalesJson << ", \"agreement_with_full\": " << (double)agree / counts.size();
+        scalesJson << ", \"hands_found\": " << (double)handsFound / counts.size();
+        // Thresholds actually used at this scale, in processing pixels: the cleanup radius cannot go below 1,
+        // so at scale 4 it covers 4 full resolution pixels instead of CLEANUP_RADIUS
+        scalesJson << ", \"cleanup_radius\": " << scaled.cleanupRadius() << ", \"min_hand_area\": " << scaled.minHandArea();
+        scalesJson << ", \"min_defect_depth\": " << scaled.minDefectDepth() / 256.0 << " }" << (scaleIndex < 2 ? ",\n" : "\n");
+    }
 
-        particles.push_back(p);
+    double totalMs = 0;
+    for (double ms : frameTimes) totalMs += ms;
+    ostringstream json;
+    json.setf(ios::fixed);
+    json.precision(2);
+    json << "{\n";
+    json << "  \"source\": \"" << source->describe() << "\",\n";
+    json << "  \"frames\": " << corpus.size() << ",\n";
+    json << "  \"repeat\": " << repeat << ",\n";
+    json << "  \"roi\": [" << pipeline.searchRect.width << ", " << pipeline.searchRect.height << "],\n";
+    json << "  \"tracking\": " << (tracking ? "true" : "false") << ",\n";
+    json << "  \"scale\": " << pipeline.scale << ",\n";
+    json << "  \"mean_roi_pixels\": " << roiPixels / frameTimes.size() << ",\n";
+    json << "  \"stages\": {\n";
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        json << "    \"" << GESTURE_STAGE_NAMES[stage] << "\": " << statsToJson(computeStats(stageTimes[stage]));
+        json << (stage + 1 < STAGE_COUNT ? ",\n" : "\n");
     }
+    json << "  },\n";
+    json << "  \"total\": " << statsToJson(computeStats(frameTimes)) << ",\n";
+    json << "  \"segmentation\": {\n";
+    json << "    \"fused\": " << statsToJson(fusedStats) << ",\n";
+    json << "    \"cvtcolor_inrange\": " << statsToJson(referenceStats) << ",\n";
+    json << "    \"color_table\": " << statsToJson(tableStats) << ",\n";
+    json << "    \"speedup\": " << (fusedStats.median > 0 ? referenceStats.median / fusedStats.median : 0.0) << ",\n";
+    json << "    \"color_table_speedup\": " << (tableStats.median > 0 ? referenceStats.median / tableStats.median : 0.0) << "\n";
+    json << "  },\n";
+    json << "  \"cleanup\": {\n";
+    json << "    \"bitpacked\": " << statsToJson(packedStats) << ",\n";
+    json << "    \"opencv\": " << statsToJson(opencvStats) << ",\n";
+    json << "    \"speedup\": " << (packedStats.median > 0 ? opencvStats.median / packedStats.median : 0.0) << "\n";
+    json << "  },\n";
+    json << "  \"extraction\": {\n";
+    json << "    \"extractor\": " << statsToJson(extractorStats) << ",\n";
+    json << "    \"findcontours_tree\": " << statsToJson(findContoursStats) << ",\n";
+    json << "    \"speedup\": " << (extractorStats.median > 0 ? findContoursStats.median / extractorStats.median : 0.0) << "\n";
+    json << "  },\n";
+    json << "  \"scales\": [\n" << scalesJson.str() << "  ],\n";
+#ifdef GESTURE_COUNT_ALLOCATIONS
+    json << "  \"allocation_counter\": \"" << ALLOCATION_COUNTER << "\",\n";
+    json << "  \"allocations_per_frame\": " << (double)steadyAllocations / frameTimes.size() << ",\n";
+    json << "  \"max_allocations_in_a_frame\": " << maxFrameAllocations << ",\n";
+#endif
+    json << "  \"fps\": " << (totalMs > 0 ? frameTimes.size() * 1000.0 / totalMs : 0.0) << "\n";
+    json << "}\n";
+
+    if (outPath.empty()) cout << json.str();
+    else {
+        ofstream out(outPath);
+        if (!out.is_open()) {
+            cerr << "Error: Could not write " << outPath << "." << endl;
+            return 1;
+        }
+        out << json.str();
+    }
+    return 0;
 }
-int getHighScore() {
-    ifstream input("highscore.txt");
-    int highScore = 0;
-    if (input.is_open()) {
-        input >> highScore;
+
+// Number of bytes that differ between two single channel masks of the same size
+// With binary set, only zero vs non-zero matters (how findContours reads a mask)
+long long countMismatches(const Mat& a, const Mat& b, bool binary = false) {
+    long long mismatches = 0;
+    for (int y = 0; y < a.rows; y++) {
+        const uchar* pa = a.ptr<uchar>(y);
+        const uchar* pb = b.ptr<uchar>(y);
+        for (int x = 0; x < a.cols; x++) mismatches += binary ? ((pa[x] != 0) != (pb[x] != 0)) : (pa[x] != pb[x]);
+    }
+    return mismatches;
+}
+
+
+// Bit-exactness checks for the custom gesture kernels against the OpenCV calls they replace
+// Usage: --verify-gesture [source spec] [--frames N], exits with 1 on any mismatch
+int runGestureVerification(int argc, char* argv[]) {
+    string spec = "synthetic";
+    int maxFrames = 300;
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc) maxFrames = max(1, atoi(argv[++i]));
+        else spec = arg;
+    }
+    int checks = 0, failures = 0;
+    auto report = [&](const string& name, long long mismatches) {
+        cout << (mismatches == 0 ? "PASS " : "FAIL ") << name << " (" << mismatches << " mismatched pixels)" << endl;
+        checks++;
+        if (mismatches != 0) failures++;
+    };
+
+    // Every 8-bit BGR color exactly once
+    Mat allColors(4096, 4096, CV_8UC3);
+    for (int y = 0; y < allColors.rows; y++) {
+        uchar* row = allColors.ptr<uchar>(y);
+        for (int x = 0; x < allColors.cols; x++) {
+            int color = y * allColors.cols + x;
+            row[3 * x] = (uchar)(color & 0xFF);
+            row[3 * x + 1] = (uchar)((color >> 8) & 0xFF);
+            row[3 * x + 2] = (uchar)(color >> 16);
+        }
+    }
+    Mat hsv, expected, actual;
+    segmentSkinReference(allColors, hsv, expected);
+    segmentSkin(allColors, actual);
+    report("segmentSkin, all 16.7M colors", countMismatches(expected, actual));
+    {
+        BitMask packed;
+        segmentSkinPacked(allColors, packed);
+        unpackMask(packed, actual);
+        report("segmentSkinPacked, all 16.7M colors", countMismatches(expected, actual, true));
+
+        // Odd width at an odd offset: unaligned rows, and every row ends in the scalar tail
+        Mat view = allColors(cv::Rect(1, 0, allColors.cols - 3, allColors.rows));
+        Mat viewExpected;
+        segmentSkinReference(view, hsv, viewExpected);
+        segmentSkin(view, actual);
+        report("segmentSkin, unaligned odd-width view of every color", countMismatches(viewExpected, actual));
+        segmentSkinPacked(view, packed);
+        unpackMask(packed, actual);
+        report("segmentSkinPacked, same view", countMismatches(viewExpected, actual, true));
+    }
+
+    // Color table: the packed lookup must agree with isSkin() for every color, and survive a save/load
+    {
+        SkinColorTable table;
+        BitMask skinBits, backgroundBits;
+        segmentSkinPacked(allColors, skinBits);
+        invertMask(skinBits, backgroundBits);
+        table.addSamples(allColors, skinBits, backgroundBits);
+        table.rebuild();
+        Mat lookups(allColors.size(), CV_8UC1);
+        for (int y = 0; y < allColors.rows; y++) {
+            const uchar* src = allColors.ptr<uchar>(y);
+            uchar* dst = lookups.ptr<uchar>(y);
+            for (int x = 0; x < allColors.cols; x++) dst[x] = table.isSkin(src[3 * x], src[3 * x + 1], src[3 * x + 2]) ? 255 : 0;
+        }
+        segmentSkinTable(allColors, skinBits, table);
+        unpackMask(skinBits, actual);
+        report("segmentSkinTable vs per-pixel lookup, all 16.7M colors", countMismatches(lookups, actual));
+
+        string path = (filesystem::temp_directory_path() / "verify_skin_table.bin").string();
+        SkinColorTable reloaded;
+        long long roundTrip = -1;
+        if (table.save(path) && reloaded.load(path)) {
+            roundTrip = 0;
+            for (int c = 0; c < 1 << 24; c++) {
+                int b = c & 0xFF, g = (c >> 8) & 0xFF, r = c >> 16;
+                if (table.isSkin(b, g, r) != reloaded.isSkin(b, g, r)) roundTrip++;
+            }
+        }
+        error_code ignored;
+        filesystem::remove(path, ignored);
+        if (roundTrip < 0) cerr << "Error: Could not write " << path << "." << endl;
+        report("skin table save/load round trip", roundTrip < 0 ? 1 : roundTrip);
+    }
+
+    // Recorded frames, through the non-continuous ROI view the pipeline uses
+    auto source = makeFrameSource(spec, FramePacing::AsFastAsPossible);
+    if (!source || !source->open()) {
+        cerr << "Error: Could not open frame source '" << spec << "'." << endl;
+        return 1;
+    }
+    GesturePipeline pipeline;
+    BitMask bits;
+    BinaryMorphology morphology;
+    TimedFrame timed;
+    long long frameMismatches = 0, cleanupMismatches = 0, fingerMismatches = 0;
+    int frames = 0;
+    while (frames < maxFrames && source->read(timed)) {
+        Mat roi = timed.image(pipeline.searchRectIn(timed.image));
+        segmentSkinReference(roi, hsv, expected);
+        segmentSkin(roi, actual);
+        frameMismatches += countMismatches(expected, actual);
+        cleanMaskReference(expected);
+        cleanMaskPacked(roi, bits, morphology, actual);
+        cleanupMismatches += countMismatches(expected, actual, true);
+
+        // Whole pipeline vs the original code path, every frame must give the same count
+        Mat original = timed.image.clone();
+        flip(original, original, 1);
+        Mat originalMask;
+        segmentSkinReference(original(pipeline.searchRectIn(original)), hsv, originalMask);
+        cleanMaskReference(originalMask);
+        int expectedFingers = countFingersReference(originalMask);
+        int actualFingers = pipeline.process(timed.image);
+        if (actualFingers != expectedFingers) {
+            fingerMismatches++;
+            cerr << "  frame " << frames << ": " << actualFingers << " fingers, original pipeline " << expectedFingers << endl;
+        }
+        frames++;
+    }
+    source->close();
+    report("segmentSkin, " + to_string(frames) + " frames from " + source->describe(), frameMismatches);
+    report("bit-packed cleanup vs erode/dilate/GaussianBlur, same frames", cleanupMismatches);
+    cout << (fingerMismatches == 0 ? "PASS " : "FAIL ") << "finger count vs original pipeline (" << fingerMismatches << " of " << frames << " frames differ, listed above)" << endl;
+    checks++;
+    if (fingerMismatches != 0) failures++;
+
+    // Speckled random masks hit the border and thin-feature cases real frames rarely do
+    mt19937 rng(12345);
+    long long noiseMismatches = 0;
+    Mat noise(pipeline.searchRect.size(), CV_8UC3);
+    for (int i = 0; i < 200; i++) {
+        int skinChance = (int)(rng() % 100);
+        for (int y = 0; y < noise.rows; y++) {
+            uchar* row = noise.ptr<uchar>(y);
+            for (int x = 0; x < noise.cols; x++) {
+                bool isSkinPixel = (int)(rng() % 100) < skinChance;
+                row[3 * x] = isSkinPixel ? 90 : 200; // Skin-ish or blue
+                row[3 * x + 1] = isSkinPixel ? 140 : 60;
+                row[3 * x + 2] = isSkinPixel ? 200 : 40;
+            }
+        }
+        segmentSkinReference(noise, hsv, expected);
+        cleanMaskReference(expected);
+        cleanMaskPacked(noise, bits, morphology, actual);
+        noiseMismatches += countMismatches(expected, actual, true);
+    }
+    report("bit-packed cleanup vs erode/dilate/GaussianBlur, 200 random masks", noiseMismatches);
+
+    // Each radius the pipeline can run (1 at scales 2 and 4), on widths around the 64-bit word edges
+    long long radiusMismatches = 0;
+    const int WIDTHS[] = { 1, 2, 63, 64, 65, 127, 128, 129, 300 };
+    for (int width : WIDTHS) {
+        for (int radius = 1; radius <= 3; radius++) {
+            for (int isErode = 0; isErode < 2; isErode++) {
+                Mat mask(37, width, CV_8UC1);
+                int skinChance = (int)(rng() % 100);
+                bits.create(width, mask.rows);
+                fill(bits.words.begin(), bits.words.end(), 0ULL);
+                for (int y = 0; y < mask.rows; y++) {
+                    for (int x = 0; x < width; x++) {
+                        bool on = (int)(rng() % 100) < skinChance;
+                        mask.at<uchar>(y, x) = on ? 255 : 0;
+                        if (on) bits.row(y)[x / 64] |= 1ULL << (x % 64);
+                    }
+                }
+                Mat kernel = getStructuringElement(MORPH_RECT, Size(2 * radius + 1, 2 * radius + 1));
+                if (isErode) {
+                    erode(mask, expected, kernel);
+                    morphology.erode(bits, radius);
+                }
+                else {
+                    dilate(mask, expected, kernel);
+                    morphology.dilate(bits, radius);
+                }
+                unpackMask(bits, actual);
+                radiusMismatches += countMismatches(expected, actual);
+            }
+        }
     }
-    return highScore;
+    report("bit-packed erode/dilate at radius 1-3 vs OpenCV, widths around word edges", radiusMismatches);
+
+    if (failures == 0) cout << "PASS all " << checks << " checks" << endl;
+    else cout << "FAIL " << failures << " of " << checks << " checks" << endl;
+    return failures == 0 ? 0 : 1;
 }
-void saveHighScore(int currentScore) {
-    int oldHigh = getHighScore();
-    if (currentScore > oldHigh) {
-        ofstream output("highscore.txt");
-        output << currentScore;
+
+// Lock quality of one stability filter over a labelled sequence
+struct LockStats {
+    int locks = 0;
+    int falseLocks = 0; // Locked a count other than the label (or during a 0 label)
+    int segmentsLocked = 0; // Labelled segments that got a correct lock
+    vector<double> latencies; // Segment start -> first correct lock, ms
+
+    void add(bool locked, int lockedCount, int label, double timestamp, double segmentStart, bool& segmentDone) {
+        if (!locked) return;
+        locks++;
+        if (lockedCount != label) falseLocks++;
+        else if (!segmentDone) {
+            segmentDone = true;
+            segmentsLocked++;
+            latencies.push_back((timestamp - segmentStart) * 1000.0);
+        }
+    }
+
+    // Adds another sequence's locks, for totals over several recordings
+    void merge(const LockStats& other) {
+        locks += other.locks;
+        falseLocks += other.falseLocks;
+        segmentsLocked += other.segmentsLocked;
+        latencies.insert(latencies.end(), other.latencies.begin(), other.latencies.end());
+    }
+
+    string toJson(int segments) const {
+        ostringstream out;
+        out.setf(ios::fixed);
+        out.precision(2);
+        SampleStats latency = computeStats(latencies);
+        out << "{ \"locks\": " << locks << ", \"false_locks\": " << falseLocks
+            << ", \"segments_locked\": " << segmentsLocked << ", \"segments\": " << segments
+            << ", \"median_latency_ms\": " << latency.median << ", \"mean_latency_ms\": " << latency.mean
+            << ", \"p99_latency_ms\": " << latency.p99 << " }";
+        return out.str();
+    }
+};
+
+// Replays labelled sequences through the pipeline and both stability filters on the frames'
+// own timestamps, prints lock latency and false locks as JSON, per source and summed over all of them.
+// --noise P replaces a share P of the detected counts with random ones (seeded), to see how
+// each filter copes with a flaky detector on clean recordings like the synthetic source
+// Usage: --eval-gesture [source spec...] [--frames N] [--window S] [--threshold T] [--noise P]
+int runGestureEvaluation(int argc, char* argv[]) {
+    vector<string> specs;
+    int maxFrames = 1800; // Per source
+    double noise = 0;
+    double window = GestureTracker::REQUIRED_HOLD_TIME;
+    double threshold = FingerVoteFilter().threshold;
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc) maxFrames = max(1, atoi(argv[++i]));
+        else if (arg == "--window" && i + 1 < argc) window = atof(argv[++i]);
+        else if (arg == "--threshold" && i + 1 < argc) threshold = std::clamp(atof(argv[++i]), 0.0, 1.0);
+        else if (arg == "--noise" && i + 1 < argc) noise = std::clamp(atof(argv[++i]), 0.0, 1.0);
+        else specs.push_back(arg);
+    }
+    if (specs.empty()) specs.push_back("synthetic");
+    // Every frame goes through the filters here, so the ring must hold the window at the fastest planned camera
+    double maxVoteWindow = FingerVoteFilter::maxWindow(0);
+    if (window < 0 || window > maxVoteWindow) {
+        window = std::clamp(window, 0.0, maxVoteWindow);
+        cerr << "Warning: --window must be between 0 and " << maxVoteWindow << " s, using " << window << " s." << endl;
+    }
+
+    mt19937 rng(12345);
+    uniform_real_distribution<double> chance(0.0, 1.0);
+    LockStats voteTotal, consecutiveTotal;
+    int totalFrames = 0, totalCorrect = 0, totalSegments = 0;
+    ostringstream sourcesJson;
+    sourcesJson.setf(ios::fixed);
+    sourcesJson.precision(3);
+    for (size_t specIndex = 0; specIndex < specs.size(); specIndex++) {
+        const string& spec = specs[specIndex];
+        auto source = makeFrameSource(spec, FramePacing::AsFastAsPossible);
+        if (!source || !source->open()) {
+            cerr << "Error: Could not open frame source '" << spec << "'." << endl;
+            return 1;
+        }
+        // Fresh pipeline and filters per recording, tracking and votes must not carry over
+        GesturePipeline pipeline;
+        FingerVoteFilter vote;
+        ConsecutiveHoldFilter consecutive;
+        vote.window = consecutive.window = window;
+        vote.threshold = threshold;
+        TimedFrame timed;
+        LockStats voteStats, consecutiveStats;
+        int frames = 0, labelledFrames = 0, correctFrames = 0, segments = 0;
+        int label = -1;
+        double segmentStart = 0;
+        bool voteDone = false, consecutiveDone = false;
+        while (frames < maxFrames && source->read(timed)) {
+            frames++;
+            if (timed.label < 0) continue;
+            int detected = pipeline.process(timed.image);
+            labelledFrames++;
+            if (detected == timed.label) correctFrames++;
+            if (noise > 0 && chance(rng) < noise) detected = (int)(rng() % (FingerVoteFilter::MAX_FINGERS + 1));
+            if (timed.label != label) { // New segment
+                label = timed.label;
+                segmentStart = timed.timestamp;
+                voteDone = consecutiveDone = false;
+                if (label > 0) segments++;
+            }
+            bool voteLocked = vote.update(timed.timestamp, detected);
+            bool consecutiveLocked = consecutive.update(timed.timestamp, detected);
+            voteStats.add(voteLocked, vote.lockedCount(), label, timed.timestamp, segmentStart, voteDone);
+            consecutiveStats.add(consecutiveLocked, consecutive.lockedCount(), label, timed.timestamp, segmentStart, consecutiveDone);
+        }
+        source->close();
+        if (labelledFrames == 0) {
+            cerr << "Error: '" << spec << "' has no labelled frames (use synthetic or images named ..._f<N>)." << endl;
+            return 1;
+        }
+
+        sourcesJson << "    { \"source\": \"" << source->describe() << "\", \"frames\": " << labelledFrames
+            << ", \"detection_accuracy\": " << (double)correctFrames / labelledFrames << ",\n";
+        sourcesJson << "      \"vote\": " << voteStats.toJson(segments) << ",\n";
+        sourcesJson << "      \"consecutive\": " << consecutiveStats.toJson(segments) << " }" << (specIndex + 1 < specs.size() ? ",\n" : "\n");
+        voteTotal.merge(voteStats);
+        consecutiveTotal.merge(consecutiveStats);
+        totalFrames += labelledFrames;
+        totalCorrect += correctFrames;
+        totalSegments += segments;
     }
+
+    cout.setf(ios::fixed);
+    cout.precision(3);
+    cout << "{\n";
+    cout << "  \"sources\": [\n" << sourcesJson.str() << "  ],\n";
+    cout << "  \"frames\": " << totalFrames << ",\n";
+    cout << "  \"detection_accuracy\": " << (double)totalCorrect / totalFrames << ",\n";
+    cout << "  \"noise\": " << noise << ",\n";
+    cout << "  \"window_s\": " << window << ",\n";
+    cout << "  \"threshold\": " << threshold << ",\n";
+    cout << "  \"vote\": " << voteTotal.toJson(totalSegments) << ",\n";
+    cout << "  \"consecutive\": " << consecutiveTotal.toJson(totalSegments) << "\n";
+    cout << "}\n";
+    return 0;
 }